@@ -3160,20 +3160,38 @@ void Alignment::extractSubAlignment(Alignment *aln, IntVector &seq_id, int min_t
     size_t oldPatternCount = size(); //JB 27-Jul-2020 Parallelized
     int    siteMod = 0; //site # modulo 100.
     size_t seqCount = seq_id.size();
+    // all the sites of a pattern of aln give the same sub-pattern, so it
+    // is extracted (and looked up) once per pattern rather than per site
+    const int SUB_PATTERN_UNSEEN = -1, SUB_PATTERN_REMOVED = -2;
+    IntVector sub_pattern(aln->size(), SUB_PATTERN_UNSEEN);
     for (size_t site = 0; site < aln->getNSite(); ++site) {
-        iterator pit = aln->begin() + (aln->getPatternID(site));
-        Pattern pat;
-        for (it = seq_id.begin(); it != seq_id.end(); ++it) {
-            pat.push_back ( (*pit)[*it] );
-        }
-        size_t gap_chars = pat.computeGapChar(num_states, STATE_UNKNOWN);
-        size_t true_char = seqCount - gap_chars;
-        if (true_char < min_true_char) {
+        int ptn = aln->getPatternID(site);
+        int sub_ptn = sub_pattern[ptn];
+        if (sub_ptn == SUB_PATTERN_REMOVED) {
             removed_sites++;
         }
+        else if (sub_ptn != SUB_PATTERN_UNSEEN) {
+            at(sub_ptn).frequency++;
+            site_pattern[site-removed_sites] = sub_ptn;
+        }
         else {
-            bool gaps_only = false;
-            addPatternLazy(pat, site-removed_sites, 1, gaps_only); //JB 27-Jul-2020 Parallelized
+            iterator pit = aln->begin() + ptn;
+            Pattern pat;
+            pat.reserve(seqCount);
+            for (it = seq_id.begin(); it != seq_id.end(); ++it) {
+                pat.push_back ( (*pit)[*it] );
+            }
+            size_t gap_chars = pat.computeGapChar(num_states, STATE_UNKNOWN);
+            size_t true_char = seqCount - gap_chars;
+            if (true_char < min_true_char) {
+                sub_pattern[ptn] = SUB_PATTERN_REMOVED;
+                removed_sites++;
+            }
+            else {
+                bool gaps_only = false;
+                addPatternLazy(pat, site-removed_sites, 1, gaps_only); //JB 27-Jul-2020 Parallelized
+                sub_pattern[ptn] = site_pattern[site-removed_sites];
+            }
         }
         if (siteMod == 100 ) {
             progress += 100;
@@ -4308,7 +4326,8 @@ double Alignment::readDist(istream &in, double *dist_mat) {
         throw "Distance file has different number of taxa";
     double *tmp_dist_mat = new double[nseqs * nseqs];
     std::map< string, int > map_seqName_ID;
-    int pos = 0, seq1, seq2, id = 0;
+    size_t pos = 0;
+    int seq1, seq2, id = 0;
     // read in distances to a temporary array
     for (seq1 = 0; seq1 < nseqs; seq1++)  {
         string seq_name;
@@ -17,6 +17,7 @@
 #include <bitset>
 #include "pattern.h"
 #include "ncl/ncl.h"
+#include "utils/distancematrix.h"
 
 const double MIN_FREQUENCY          = 0.0001;
 const double MIN_FREQUENCY_DIFF     = 0.00001;
@@ -666,6 +667,13 @@ public:
      @param[out] support number of sites supporting 12|34, 13|24 and 14|23
      */
     virtual void computeQuartetSupports(IntVector &quartet, vector<int64_t> &support);
+
+    /**
+     build the columns of informative patterns that computeQuartetSupports
+     scans, once for all quartets (call it before computing quartet supports,
+     and before doing so in parallel)
+     */
+    virtual void buildQuartetSupportColumns();
     
     /****************************************************************************
             Distance functions
@@ -719,6 +727,44 @@ public:
      */
     void printDist(ostream &out, double *dist_mat);
 
+    /**
+            write a packed (upper-triangular) distance matrix into a file in PHYLIP distance format
+            @param file_name distance file name
+            @param dist_mat packed distance matrix
+     */
+    template <class T> void printDist(const char *file_name, const PackedDistanceMatrix<T> &dist_mat) {
+        try {
+            ofstream out;
+            out.exceptions(ios::failbit | ios::badbit);
+            out.open(file_name);
+            printDist(out, dist_mat);
+            out.close();
+        } catch (ios::failure &) {
+            outError(ERR_WRITE_OUTPUT, file_name);
+        }
+    }
+
+    /**
+            write a packed (upper-triangular) distance matrix into a stream in PHYLIP distance format
+            (as a square matrix, row by row, as per printDist(ostream&, double*))
+            @param out output stream
+            @param dist_mat packed distance matrix
+     */
+    template <class T> void printDist(ostream &out, const PackedDistanceMatrix<T> &dist_mat) {
+        size_t nseqs = getNSeq();
+        int max_len = getMaxSeqNameLength();
+        if (max_len < 10) max_len = 10;
+        out << nseqs << endl;
+        out.precision(max((int)ceil(-log10(Params::getInstance().min_branch_length))+1, 6));
+        out << fixed;
+        for (size_t seq1 = 0; seq1 < nseqs; ++seq1)  {
+            out.width(max_len);
+            out << left << getSeqName(seq1) << " ";
+            dist_mat.writeRow(out, seq1);
+            out << endl;
+        }
+    }
+
     /**
             read distance matrix from a file in PHYLIP distance format
             @param file_name distance file name
@@ -1038,6 +1084,23 @@ protected:
      */
     double* cache_ntfreq = NULL;
 
+    /**
+            states of the informative patterns, one column per sequence
+            (of quartet_column_freqs.size() states), for computeQuartetSupports.
+            Gaps and ambiguous states are stored as UCHAR_MAX
+     */
+    vector<unsigned char> quartet_columns;
+
+    /**
+            frequencies of the patterns in quartet_columns
+     */
+    IntVector quartet_column_freqs;
+
+    /**
+            true if quartet_columns was built by buildQuartetSupportColumns
+     */
+    bool quartet_columns_built = false;
+
 private:
     /**
         Generate a reference genome from input_sequences
@@ -19,6 +19,7 @@
  ***************************************************************************/
 #include "alignmentpairwise.h"
 #include "tree/phylosupertree.h"
+#include "utils/hammingdistance.h"
 
 AlignmentPairwise::AlignmentPairwise()
         : Alignment(), Optimization()
@@ -491,6 +492,18 @@ double AlignmentPairwise::recomputeDist
             auto sequence2        = tree->getConvertedSequenceByNumber(seq2);
             auto nonConstSiteFreq = tree->getConvertedSequenceNonConstFrequencies();
             size_t sequenceLength = tree->getConvertedSequenceLength();
+#if !defined(__ARM_NEON)
+            if (STATE_UNKNOWN <= 127) {
+                //Vectorized: sites where either state is unknown
+                //are excluded from both distance and denominator.
+                double unknownFreq = 0;
+                distance    = static_cast<int>(hammingDistance
+                                ( static_cast<char>(STATE_UNKNOWN), sequence1, sequence2
+                                , static_cast<int>(sequenceLength), nonConstSiteFreq, unknownFreq ));
+                denominator = static_cast<int>(tree->getSumOfConvertedSequenceNonConstFrequencies())
+                            - static_cast<int>(unknownFreq);
+            } else
+#endif
             for (size_t i=0; i<sequenceLength; ++i) {
                 auto state1 = sequence1[i];
                 auto state2 = sequence2[i];
@@ -7,12 +7,15 @@
 
 #include "alignment.h"
 #include "alignmentsummary.h"
+#include <algorithm> //for std::stable_sort
 
 AlignmentSummary::AlignmentSummary(const Alignment* a
                                    , bool keepConstSites
                                    , bool keepBoringSites) {
     alignment      = a;
     sequenceMatrix = nullptr;
+    packedMatrix   = nullptr;
+    packedWordCount = 0;
     sequenceCount  = a->getNSeq();
     totalFrequency = 0;
     totalFrequencyOfNonConstSites = 0;
@@ -97,6 +100,8 @@ AlignmentSummary::AlignmentSummary(const Alignment* a
 AlignmentSummary::~AlignmentSummary() {
     delete [] sequenceMatrix;
     sequenceMatrix = nullptr;
+    delete [] packedMatrix;
+    packedMatrix   = nullptr;
     sequenceLength = 0;
     sequenceCount  = 0;
 }
@@ -159,3 +164,83 @@ bool AlignmentSummary::constructSequenceMatrix ( bool treatAllAmbiguousStatesAsU
     }
     return true;
 }
+
+bool AlignmentSummary::constructPackedMatrix ( progress_display* progress ) {
+    //Packs the states at the sites in siteNumbers (2 bits of state,
+    //and 1 "known" bit, per site per sequence).  Only for alignments
+    //with exactly 4 states (DNA).  Sites are ordered by frequency,
+    //and each run of sites with the same frequency starts a new word.
+    delete [] packedMatrix;
+    packedMatrix    = nullptr;
+    packedWordCount = 0;
+    packedGroupStops.clear();
+    packedGroupWeights.clear();
+    if ( alignment->num_states != 4 ) {
+        return false;
+    }
+    std::vector<size_t> order(sequenceLength);
+    for (size_t seqPos = 0; seqPos < sequenceLength; ++seqPos) {
+        order[seqPos] = seqPos;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return siteFrequencies[a] < siteFrequencies[b];
+    });
+    const size_t notPacked = static_cast<size_t>(-1);
+    std::vector<size_t> seqPosToBit(sequenceLength, notPacked);
+    size_t bit = 0;
+    for (size_t i = 0; i < sequenceLength; ++i) {
+        size_t seqPos = order[i];
+        int    weight = siteFrequencies[seqPos];
+        if (weight == 0) {
+            continue;
+        }
+        if (packedGroupWeights.empty() || packedGroupWeights.back() != weight) {
+            if (!packedGroupWeights.empty()) {
+                bit = (bit + 63) & ~(size_t)63;
+                packedGroupStops.push_back(bit / 64);
+            }
+            packedGroupWeights.push_back(weight);
+        }
+        seqPosToBit[seqPos] = bit++;
+    }
+    bit = (bit + 63) & ~(size_t)63;
+    if (!packedGroupWeights.empty()) {
+        packedGroupStops.push_back(bit / 64);
+    }
+    packedWordCount = bit / 64;
+    size_t wordsPerSequence = packedWordCount * 3;
+    packedMatrix = new uint64_t[ sequenceCount * wordsPerSequence ];
+    const int* posToSite = siteNumbers.data();
+    #ifdef _OPENMP
+    #pragma omp parallel for
+    #endif
+    for (size_t seq=0; seq<sequenceCount; ++seq) { //sequence
+        uint64_t* packed = packedMatrix + seq * wordsPerSequence;
+        for (size_t w = 0; w < wordsPerSequence; ++w) {
+            packed[w] = 0;
+        }
+        for (size_t seqPos = 0; seqPos < sequenceLength; ++seqPos) {
+            size_t b = seqPosToBit[seqPos];
+            if (b == notPacked) {
+                continue;
+            }
+            auto state = alignment->at(posToSite[seqPos])[seq];
+            if (4 <= state) {
+                continue; //gap, ambiguous, or unknown
+            }
+            uint64_t* word = packed + (b / 64) * 3;
+            uint64_t  mask = (uint64_t)1 << (b % 64);
+            if (state & 2) {
+                word[0] |= mask;
+            }
+            if (state & 1) {
+                word[1] |= mask;
+            }
+            word[2] |= mask;
+        }
+        if (progress != nullptr && (seq % 100) == 0) {
+            (*progress) += 100;
+        }
+    }
+    return true;
+}
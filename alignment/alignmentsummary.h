@@ -10,6 +10,7 @@
 
 #include <vector>
 #include <map>
+#include <cstdint>          //for uint64_t
 #include <utils/progress.h> //for progress_display
 
 /**
@@ -37,11 +38,19 @@ public:
     char*              sequenceMatrix;
     size_t             sequenceLength;  //Sequence length
     size_t             sequenceCount;   //The number of sequences
+    uint64_t*          packedMatrix;    //DNA sequences, bit-packed (see hammingdistance.h)
+    size_t             packedWordCount; //words (in each bit-plane) per packed sequence
+    std::vector<size_t> packedGroupStops;   //word at which each group of sites ends
+    std::vector<int>    packedGroupWeights; //frequency of each site in each group
     size_t             getSumOfConstantSiteFrequenciesForState(int state);
     bool constructSequenceMatrix ( bool treatAllAmbiguousStatesAsUnknown
                                  , progress_display *progress = nullptr);
     bool constructSequenceMatrixNoisily ( bool treatAllAmbiguousStatesAsUnknown, 
         const char* taskName, const char* verb);
+    bool constructPackedMatrix ( progress_display *progress = nullptr );
+    const uint64_t* getPackedSequence(size_t seq) const {
+        return packedMatrix + seq * packedWordCount * 3;
+    }
 };
 
 #endif /* alignmentsummary_hpp */
@@ -258,6 +258,11 @@ public:
      @param[out] support number of sites supporting 12|34, 13|24 and 14|23
      */
     virtual void computeQuartetSupports(IntVector &quartet, vector<int64_t> &support);
+
+    /**
+     build the columns scanned by computeQuartetSupports, for each partition
+     */
+    virtual void buildQuartetSupportColumns();
     
 	/**
 		@return unconstrained log-likelihood (without a tree)
@@ -886,6 +886,8 @@ void searchGAMMAInvarByRestarting(IQTree &iqtree);
 
 void computeLoglFromUserInputGAMMAInvar(Params &params, IQTree &iqtree);
 
+bool isDistanceStreamingWanted(Params& params, IQTree& iqtree);
+
 void printOutfilesInfo(Params &params, IQTree &tree) {
 
     cout << endl << "Analysis results written to: " << endl;
@@ -913,9 +915,15 @@ void printOutfilesInfo(Params &params, IQTree &tree) {
         cout << "  BIONJ tree:                    " << params.out_prefix << ".bionj"
                 << endl;
     }
+    if (!params.user_file && params.start_tree == STT_SKETCH) {
+        cout << "  Sketch tree:                   " << params.out_prefix << ".sketchtree"
+                << endl;
+    }
     if (!params.dist_file) {
         //cout << "  Juke-Cantor distances:    " << params.out_prefix << ".jcdist" << endl;
-        if (params.compute_ml_dist)
+        // no distance file if the distances were streamed into the start tree builder
+        if (params.compute_ml_dist && (!isDistanceStreamingWanted(params, tree)
+                                       || !tree.getDistanceFileWritten().empty()))
         cout << "  Likelihood distances:          " << params.out_prefix
                     << ".mldist" << endl;
         if (params.print_conaln)
@@ -956,7 +964,8 @@ void printOutfilesInfo(Params &params, IQTree &tree) {
                 << endl;
 
     if (params.print_ancestral_sequence) {
-        cout << "  Ancestral state:               " << params.out_prefix << ".state" << endl;
+        cout << "  Ancestral state:               " << params.out_prefix << ".state"
+                << (params.do_compression ? ".gz" : "") << endl;
 //        cout << "  Ancestral sequences:           " << params.out_prefix << ".aseq" << endl;
     }
 
@@ -983,7 +992,7 @@ void printOutfilesInfo(Params &params, IQTree &tree) {
             cout << "  Root testing results:          " << params.out_prefix << ".roottest.csv" << endl;
         }
         if (params.print_ufboot_trees)
-        cout << "  UFBoot trees:                  " << params.out_prefix << ".ufboot" << endl;
+        cout << "  UFBoot trees:                  " << params.out_prefix << ".ufboot" << (params.print_ufboot_bin ? ".bin" : "") << endl;
 
     }
 
@@ -1929,20 +1938,74 @@ void printAnalysisInfo(int model_df, IQTree& iqtree, Params& params) {
     cout << endl;
 }
 
+/**
+ * @return true if the square distance matrices (PhyloTree::dist_matrix and
+ *         var_matrix) will be needed after the start tree has been
+ *         constructed (by -iqp, least-squares branch lengths or NNI, or when
+ *         stable clades are collapsed, in pruneTaxa).
+ */
+bool areDistanceMatricesNeededLater(Params& params) {
+    return params.leastSquareBranch || params.leastSquareNNI || params.iqp
+        || (params.aLRT_threshold <= 100
+            && (params.aLRT_replicates > 0 || params.localbp_replicates > 0));
+}
+
+/**
+ * @return true if distances are to be calculated only as the start tree
+ *         builder (see PhyloTree::computeBioNJ) loads them. Not if distances
+ *         are read from a file, or will be needed again after the start tree
+ *         has been constructed, or if no start tree will be built from
+ *         them (as then they'd never be calculated, or written out).
+ */
+bool isDistanceStreamingWanted(Params& params, IQTree& iqtree) {
+    return params.stream_dist && !params.dist_file && !params.compute_obs_dist
+        && !areDistanceMatricesNeededLater(params) && !iqtree.isSuperTree()
+        && !params.user_file && !params.constraint_tree_file
+        && params.start_tree != STT_RANDOM_TREE;
+}
+
+/**
+ * @return true if distances are to be calculated into a packed matrix
+ *         (see PhyloTree::computePackedDist), rather than square matrices.
+ *         Ruled out in the same cases as streaming
+ *         (see isDistanceStreamingWanted).
+ */
+bool isDistancePackingWanted(Params& params, IQTree& iqtree) {
+    return params.packed_dist && !params.dist_file
+        && !areDistanceMatricesNeededLater(params) && !iqtree.isSuperTree()
+        && !params.user_file && !params.constraint_tree_file
+        && params.start_tree != STT_RANDOM_TREE;
+}
+
 void computeMLDist ( Params& params, IQTree& iqtree
                    , double begin_wallclock_time, double begin_cpu_time) {
     double longest_dist;
+    if (isDistanceStreamingWanted(params, iqtree)) {
+        cout << "ML distances will be computed as the "
+             << params.start_tree_subtype_name << " tree is constructed"
+             << " (no distance file is written)" << endl;
+        iqtree.prepareToStreamDist(params, iqtree.aln);
+        return;
+    }
     cout << "Computing ML distances based on estimated model parameters..." << endl;
     double *ml_dist = nullptr;
     double *ml_var  = nullptr;
     iqtree.decideDistanceFilePath(params);
-    longest_dist = iqtree.computeDist(params, iqtree.aln, ml_dist, ml_var);
+    if (isDistancePackingWanted(params, iqtree)) {
+        //No square matrices; the packed matrix is kept for computeBioNJ
+        longest_dist = iqtree.computePackedDist(params, iqtree.aln);
+    } else {
+        longest_dist = iqtree.computeDist(params, iqtree.aln, ml_dist, ml_var);
+    }
     cout << "Computing ML distances took "
         << (getRealTime() - begin_wallclock_time) << " sec (of wall-clock time) "
         << (getCPUTime() - begin_cpu_time) << " sec (of CPU time)" << endl;
     size_t n = iqtree.aln->getNSeq();
     size_t nSquared = n*n;
-    if ( iqtree.dist_matrix == nullptr ) {
+    if ( ml_dist == nullptr ) {
+        //Packed distances were written to the distance file
+        //(by computePackedDist) and aren't kept in square matrices.
+    } else if ( iqtree.dist_matrix == nullptr ) {
         iqtree.dist_matrix = ml_dist;
         ml_dist = nullptr;
     } else {
@@ -1950,7 +2013,9 @@ void computeMLDist ( Params& params, IQTree& iqtree
                 sizeof(double) * nSquared);
         delete[] ml_dist;
     }
-    if ( iqtree.var_matrix == nullptr ) {
+    if ( ml_var == nullptr ) {
+        //As above
+    } else if ( iqtree.var_matrix == nullptr ) {
         iqtree.var_matrix = ml_var;
         ml_var = nullptr;
     } else {
@@ -1983,7 +2048,16 @@ void computeInitialDist(Params &params, IQTree &iqtree) {
     }
 
     if (params.compute_jc_dist || params.compute_obs_dist || params.partition_file) {
-        longest_dist = iqtree.computeDist(params, iqtree.aln, iqtree.dist_matrix, iqtree.var_matrix);
+        if (isDistanceStreamingWanted(params, iqtree)) {
+            //Distances will be computed by computeBioNJ
+            iqtree.prepareToStreamDist(params, iqtree.aln);
+            return;
+        }
+        if (isDistancePackingWanted(params, iqtree)) {
+            longest_dist = iqtree.computePackedDist(params, iqtree.aln);
+        } else {
+            longest_dist = iqtree.computeDist(params, iqtree.aln, iqtree.dist_matrix, iqtree.var_matrix);
+        }
         //if (!params.suppress_zero_distance_warnings) {
         //  checkZeroDist(iqtree.aln, iqtree.dist_matrix);
         //}
@@ -2740,8 +2814,9 @@ void runTreeReconstruction(Params &params, IQTree* &iqtree) {
         if (iqtree->isSuperTreeUnlinked()) {
             params.compute_ml_dist = false;
         }
-        //Todo: Check: is it always true that we've done this, if we reach this line?
-        cout << "Wrote distance file to... " << iqtree->getDistanceFileWritten() << endl;
+        if (!iqtree->getDistanceFileWritten().empty()) {
+            cout << "Wrote distance file to... " << iqtree->getDistanceFileWritten() << endl;
+        }
     }
     bool wantMLDistances = MPIHelper::getInstance().isMaster() && !iqtree->getCheckpoint()->getBool("finishedCandidateSet");
     if (wantMLDistances) {
@@ -2802,6 +2877,8 @@ void runTreeReconstruction(Params &params, IQTree* &iqtree) {
                 << getRealTime() - write_begin_time << " seconds " << endl;
             }
         }
+        //(if no start tree was built from it)
+        iqtree->releasePackedDist();
     }
     //iqtree->saveCheckpoint();
     double cputime_search_start = getCPUTime();
@@ -4210,6 +4287,8 @@ void runPhyloAnalysis(Params &params, Checkpoint *checkpoint, IQTree *&tree, Ali
             params.start_tree = STT_PARSIMONY;
         else if (params.start_tree == STT_BIONJ)
             outError("Constraint tree does not work with -t BIONJ");
+        else if (params.start_tree == STT_SKETCH)
+            outError("Constraint tree does not work with -t SKETCH");
         if (params.num_bootstrap_samples || params.gbo_replicates)
             cout << "INFO: Constraint tree will be applied to ML tree and all bootstrap trees." << endl;
     }
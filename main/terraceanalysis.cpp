@@ -291,14 +291,7 @@ void run_generate_trees(Terrace *terrace, Params &params,const int m){
     
     //init_terrace->print_ALL_DATA(part_tree_pairs);
     if(params.print_terrace_trees){
-        ofstream out;
-        out.exceptions(ios::failbit | ios::badbit);
-        out.open(init_terrace->out_file);
-        out.close();
-        
-        init_terrace->out.exceptions(ios::failbit | ios::badbit);
-        init_terrace->out.open(init_terrace->out_file,std::ios_base::app);
-        
+        init_terrace->open_terrace_trees_file(params.do_compression);
     }else{
         init_terrace->terrace_out = false;
     }
@@ -18,6 +18,8 @@
 #include "tree/iqtreemix.h"
 #include "gsl/mygsl.h"
 #include "utils/timeutil.h"
+#include "utils/gzstream.h"
+#include <Eigen/Core>
 
 
 void printSiteLh(const char*filename, PhyloTree *tree, double *ptn_lh,
@@ -219,11 +221,18 @@ void printAncestralSequences(const char *out_prefix, PhyloTree *tree, AncestralS
     
     string filename = (string)out_prefix + ".state";
     //    string filenameseq = (string)out_prefix + ".stateseq";
+    bool compression = tree->params->do_compression;
+    if (compression)
+        filename += ".gz";
     
     try {
-        ofstream out;
+        ostream *out_stream;
+        if (compression)
+            out_stream = new ogzstream(filename.c_str());
+        else
+            out_stream = new ofstream(filename.c_str());
+        ostream &out = *out_stream;
         out.exceptions(ios::failbit | ios::badbit);
-        out.open(filename.c_str());
         out.setf(ios::fixed, ios::floatfield);
         out.precision(5);
         
@@ -310,7 +319,11 @@ void printAncestralSequences(const char *out_prefix, PhyloTree *tree, AncestralS
         
         tree->endMarginalAncestralState(orig_kernel_nonrev, marginal_ancestral_prob, marginal_ancestral_seq);
         
-        out.close();
+        if (compression)
+            ((ogzstream*)out_stream)->close();
+        else
+            ((ofstream*)out_stream)->close();
+        delete out_stream;
         //        outseq.close();
         cout << "Ancestral state probabilities printed to " << filename << endl;
         //        cout << "Ancestral sequences printed to " << filenameseq << endl;
@@ -782,6 +795,36 @@ int mlecoef(double *cnts, double *rr, double bb, int kk,
 
 /* END CODE WAS TAKEN FROM CONSEL PROGRAM */
 
+/** maximal number of bootstrap replicates whose pattern weights are kept together */
+const size_t TOPOTEST_REPLICATE_BLOCK = 64;
+
+/**
+ @return number of bootstrap replicates generated and scored together,
+ such that their pattern weights take at most 16 MB
+ */
+static size_t getReplicateBlockSize(size_t nboot, size_t maxnptn) {
+    size_t block = ((size_t)1 << 21) / maxnptn;
+    return max(min(min(block, TOPOTEST_REPLICATE_BLOCK), nboot), (size_t)1);
+}
+
+/**
+ compute the RELL log-likelihoods of all trees for a block of bootstrap replicates,
+ as one matrix product of pattern log-likelihoods and pattern weights
+ @param pattern_lhs pattern log-likelihoods, #trees x maxnptn
+ @param weights pattern weights, #replicates x maxnptn
+ @param[out] tree_lhs RELL log-likelihoods, #trees x #replicates with row stride tree_lhs_stride
+ */
+static void computeReplicateLh(double *pattern_lhs, size_t ntrees, double *weights, size_t nreps,
+                               size_t nptn, size_t maxnptn, double *tree_lhs, size_t tree_lhs_stride)
+{
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrix;
+    typedef Eigen::Map<RowMatrix, 0, Eigen::OuterStride<> > RowMatrixMap;
+    RowMatrixMap lhs(pattern_lhs, ntrees, nptn, Eigen::OuterStride<>(maxnptn));
+    RowMatrixMap wgt(weights, nreps, nptn, Eigen::OuterStride<>(maxnptn));
+    RowMatrixMap res(tree_lhs, ntrees, nreps, Eigen::OuterStride<>(tree_lhs_stride));
+    res.noalias() = lhs * wgt.transpose();
+}
+
 /**
  @param tree_lhs RELL score matrix of size #trees x #replicates
  */
@@ -830,58 +873,62 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
     int *rstream = randstream;
 #endif
     size_t boot;
+    size_t block_size = getReplicateBlockSize(nboot, maxnptn);
     int *boot_sample = aligned_alloc<int>(maxnptn);
     memset(boot_sample, 0, maxnptn*sizeof(int));
     
-    double *boot_sample_dbl = aligned_alloc<double>(maxnptn);
+    double *boot_sample_dbl = aligned_alloc<double>(block_size*maxnptn);
     
 #ifdef _OPENMP
 #pragma omp for schedule(dynamic)
 #endif
     for (int k = 0; k < nscales; ++k) {
         string str = "SCALE=" + convertDoubleToString(r[k]);
-        for (boot = 0; boot < nboot; boot++) {
-            if (r[k] == 1.0 && boot == 0)
-                // 2018-10-23: get one of the bootstrap sample as the original alignment
-                tree->aln->getPatternFreq(boot_sample);
-            else
-                tree->aln->createBootstrapAlignment(boot_sample, str.c_str(), rstream);
-            for (ptn = 0; ptn < maxnptn; ptn++)
-                boot_sample_dbl[ptn] = boot_sample[ptn];
-            double max_lh = -DBL_MAX, second_max_lh = -DBL_MAX;
-            int max_tid = -1;
-            for (tid = 0; tid < ntrees; tid++) {
-                double *pattern_lh = pattern_lhs + (tid*maxnptn);
-                double tree_lh;
-                if (params.SSE == LK_386) {
-                    tree_lh = 0.0;
-                    for (ptn = 0; ptn < nptn; ptn++)
-                        tree_lh += pattern_lh[ptn] * boot_sample_dbl[ptn];
-                } else {
-                    tree_lh = tree->dotProductDoubleCall(pattern_lh, boot_sample_dbl, nptn);
-                }
-                // rescale lh
-                tree_lh /= r[k];
-                
-                // find the max and second max
-                if (tree_lh > max_lh) {
-                    second_max_lh = max_lh;
-                    max_lh = tree_lh;
-                    max_tid = tid;
-                } else if (tree_lh > second_max_lh)
-                    second_max_lh = tree_lh;
-                
-                treelhs[(tid*nscales+k)*nboot + boot] = tree_lh;
+        // scores of the trees for scale k are rows with stride nscales*nboot
+        double *scale_treelhs = treelhs + k*nboot;
+        for (size_t block_start = 0; block_start < nboot; block_start += block_size) {
+            size_t block_end = min(block_start + block_size, nboot);
+            for (boot = block_start; boot < block_end; boot++) {
+                if (r[k] == 1.0 && boot == 0)
+                    // 2018-10-23: get one of the bootstrap sample as the original alignment
+                    tree->aln->getPatternFreq(boot_sample);
+                else
+                    tree->aln->createBootstrapAlignment(boot_sample, str.c_str(), rstream);
+                double *this_sample = boot_sample_dbl + (boot-block_start)*maxnptn;
+                for (ptn = 0; ptn < nptn; ptn++)
+                    this_sample[ptn] = boot_sample[ptn];
             }
+            computeReplicateLh(pattern_lhs, ntrees, boot_sample_dbl, block_end-block_start,
+                               nptn, maxnptn, scale_treelhs + block_start, nscales*nboot);
             
-            // compute difference from max_lh
-            for (tid = 0; tid < ntrees; tid++)
-                if (tid != max_tid)
-                    treelhs[(tid*nscales+k)*nboot + boot] = max_lh - treelhs[(tid*nscales+k)*nboot + boot];
-                else
-                    treelhs[(tid*nscales+k)*nboot + boot] = second_max_lh - max_lh;
-            //            bp[k*ntrees+max_tid] += nboot_inv;
-        } // for boot
+            for (boot = block_start; boot < block_end; boot++) {
+                double max_lh = -DBL_MAX, second_max_lh = -DBL_MAX;
+                int max_tid = -1;
+                for (tid = 0; tid < ntrees; tid++) {
+                    double &tree_lh = scale_treelhs[tid*nscales*nboot + boot];
+                    // rescale lh
+                    tree_lh /= r[k];
+                    
+                    // find the max and second max
+                    if (tree_lh > max_lh) {
+                        second_max_lh = max_lh;
+                        max_lh = tree_lh;
+                        max_tid = tid;
+                    } else if (tree_lh > second_max_lh)
+                        second_max_lh = tree_lh;
+                }
+                
+                // compute difference from max_lh
+                for (tid = 0; tid < ntrees; tid++) {
+                    double &tree_lh = scale_treelhs[tid*nscales*nboot + boot];
+                    if (tid != max_tid)
+                        tree_lh = max_lh - tree_lh;
+                    else
+                        tree_lh = second_max_lh - max_lh;
+                }
+                //            bp[k*ntrees+max_tid] += nboot_inv;
+            } // for boot
+        } // for block
         
         // sort the replicates
         for (tid = 0; tid < ntrees; tid++) {
@@ -1054,6 +1101,104 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
 }
 
 
+/**
+ prepare a tree that was just read for evaluation and compute its log-likelihood,
+ optimizing branch lengths (and model parameters) unless they are fixed
+ */
+static void evaluateTree(PhyloTree *tree, Params &params) {
+    if (!tree->findNodeName(tree->aln->getSeqName(0))) {
+        outError("Taxon " + tree->aln->getSeqName(0) + " not found in tree");
+    }
+    
+    if (tree->rooted && tree->getModelFactory()->isReversible()) {
+        if (tree->leafNum != tree->aln->getNSeq()+1)
+            outError("Tree does not have same number of taxa as alignment");
+        tree->convertToUnrooted();
+//            cout << "convertToUnrooted" << endl;
+    } else if (!tree->rooted && !tree->getModelFactory()->isReversible()) {
+        if (tree->leafNum != tree->aln->getNSeq())
+            outError("Tree does not have same number of taxa as alignment");
+        tree->convertToRooted();
+//            cout << "convertToRooted" << endl;
+    }
+    tree->setAlignment(tree->aln);
+    tree->setRootNode(params.root);
+    if (tree->isSuperTree())
+        ((PhyloSuperTree*) tree)->mapTrees();
+    
+    tree->initializeAllPartialLh();
+    tree->fixNegativeBranch(false);
+    if (params.fixed_branch_length) {
+        tree->setCurScore(tree->computeLikelihood());
+    } else if (params.topotest_optimize_model) {
+        tree->getModelFactory()->optimizeParameters(BRLEN_OPTIMIZE, false, params.modelEps);
+        tree->setCurScore(tree->computeLikelihood());
+    } else {
+        tree->setCurScore(tree->optimizeAllBranches(100, 0.001));
+    }
+}
+
+/** skip the next tree in a tree stream */
+static void skipTree(istream &in) {
+    char ch;
+    do {
+        in >> ch;
+    } while (!in.eof() && ch != ';');
+}
+
+/**
+ @return TRUE if trees can be evaluated in parallel, each thread with its own tree sharing
+ the alignment and the model of the given tree: model parameters must stay fixed and the
+ partial likelihoods of one tree per thread must fit into memory
+ */
+static bool canEvaluateTreesInParallel(Params &params, IQTree *tree, size_t ntrees) {
+#ifdef _OPENMP
+    int num_threads = tree->num_threads;
+    if (num_threads <= 1 || ntrees < 2*num_threads)
+        return false;
+    if (tree->isSuperTree() || tree->isTreeMix() || tree->isMixlen() || params.topotest_optimize_model)
+        return false;
+    if (params.print_partition_lh)
+        return false;
+    // stored transition matrices are not shared safely among threads
+    if (tree->getModelFactory()->store_trans_matrix)
+        return false;
+    // non-reversible models write to the shared model (nondiagonalizable)
+    // when computing transition matrices
+    if (!tree->getModel()->isReversible())
+        return false;
+    return tree->getMemoryRequired()*num_threads < getMemorySize();
+#else
+    return false;
+#endif
+}
+
+/**
+ @return a new tree for one thread, which shares alignment, model and rates with tree
+ and computes likelihoods with a single thread
+ */
+static PhyloTree *newThreadTree(IQTree *tree, Params &params) {
+    PhyloTree *thread_tree = new PhyloTree(tree->aln);
+    thread_tree->setParams(&params);
+    thread_tree->optimize_by_newton = params.optimize_by_newton;
+    thread_tree->rooted = tree->rooted;
+    // the kernel is chosen by the model (e.g. non-reversible), so the model comes first
+    thread_tree->setModelFactory(tree->getModelFactory());
+    thread_tree->setModel(tree->getModel());
+    thread_tree->setRate(tree->getRate());
+    thread_tree->setLikelihoodKernel(params.SSE);
+    thread_tree->setNumThreads(1);
+    return thread_tree;
+}
+
+/** delete a tree made by newThreadTree(), leaving the shared model and rates alone */
+static void deleteThreadTree(PhyloTree *thread_tree) {
+    thread_tree->setModel(NULL);
+    thread_tree->setModelFactory(NULL);
+    thread_tree->setRate(NULL);
+    delete thread_tree;
+}
+
 void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &info, IntVector &distinct_ids)
 {
     cout << endl;
@@ -1102,7 +1247,6 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
     
     double time_start = getRealTime();
     
-    int *boot_samples = NULL;
     //double *saved_tree_lhs = NULL;
     double *tree_lhs = NULL; // RELL score matrix of size #trees x #replicates
     double *pattern_lh = NULL;
@@ -1114,36 +1258,15 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
     size_t maxnptn = get_safe_upper_limit(nptn);
     
     if (params.topotest_replicates && ntrees > 1) {
-        size_t mem_size = (size_t)params.topotest_replicates*nptn*sizeof(int) +
+        size_t mem_size = ntrees*maxnptn*sizeof(double) +
+        getReplicateBlockSize(params.topotest_replicates, maxnptn)*maxnptn*sizeof(double) +
         ntrees*params.topotest_replicates*sizeof(double) +
         (nptn + ntrees*3 + params.topotest_replicates*2)*sizeof(double) +
         ntrees*sizeof(TreeInfo) +
-        params.do_weighted_test*(ntrees * nptn * sizeof(double) + ntrees*ntrees*sizeof(double));
+        params.do_weighted_test*(ntrees*ntrees*sizeof(double));
         cout << "Note: " << ((double)mem_size/1024)/1024 << " MB of RAM required!" << endl;
         if (mem_size > getMemorySize()-100000)
             outWarning("The required memory does not fit in RAM!");
-        cout << "Creating " << params.topotest_replicates << " bootstrap replicates..." << endl;
-        if (!(boot_samples = new int [params.topotest_replicates*nptn]))
-            outError(ERR_NO_MEMORY);
-#ifdef _OPENMP
-#pragma omp parallel if(nptn > 10000)
-        {
-        int *rstream;
-        init_random(params.ran_seed + omp_get_thread_num(), false, &rstream);
-#pragma omp for schedule(static)
-#else
-        int *rstream = randstream;
-#endif
-        for (size_t boot = 0; boot < params.topotest_replicates; boot++)
-            if (boot == 0)
-                tree->aln->getPatternFreq(boot_samples + (boot*nptn));
-            else
-                tree->aln->createBootstrapAlignment(boot_samples + (boot*nptn), params.bootstrap_spec, rstream);
-#ifdef _OPENMP
-        finish_random(rstream);
-        }
-#endif
-        cout << "done" << endl;
         //if (!(saved_tree_lhs = new double [ntrees * params.topotest_replicates]))
         //    outError(ERR_NO_MEMORY);
         if (!(tree_lhs = new double [ntrees * params.topotest_replicates]))
@@ -1151,10 +1274,9 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
         if (params.do_weighted_test || params.do_au_test) {
             if (!(lhdiff_weights = new double [ntrees * ntrees]))
                 outError(ERR_NO_MEMORY);
-            pattern_lhs = aligned_alloc<double>(ntrees*maxnptn);
-            //            if (!(pattern_lhs = new double[ntrees* nptn]))
-            //                outError(ERR_NO_MEMORY);
         }
+        // RELL scores are computed from the pattern log-likelihoods of all trees at once
+        pattern_lhs = aligned_alloc<double>(ntrees*maxnptn);
         pattern_lh = aligned_alloc<double>(maxnptn);
         //        if (!(pattern_lh = new double[nptn]))
         //            outError(ERR_NO_MEMORY);
@@ -1167,51 +1289,106 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
     info.resize(ntrees);
     string saved_tree;
     saved_tree = tree->getTreeString();
-    //for (MTreeSet::iterator it = trees.begin(); it != trees.end(); it++, tree_index++) {
+    if (canEvaluateTreesInParallel(params, tree, ntrees)) {
+        // trees are read one at a time by whichever thread is free; results are
+        // written in input order as soon as all preceding trees are done
+        cout << "Evaluating " << tree->num_threads << " trees at a time" << endl;
+        vector<string> tree_strings(ntrees);
+        // site log-likelihoods of trees waiting to be written, if not kept for RELL anyway
+        vector<vector<double> > tree_site_lhs(pattern_lhs ? 0 : ntrees);
+        vector<streamsize> tree_precisions(ntrees);
+        vector<bool> tree_done(ntrees, false);
+        size_t read_index = 0, read_tid = 0, write_index = 0, write_tid = 0;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(tree->num_threads)
+#endif
+        {
+            PhyloTree *thread_tree = newThreadTree(tree, params);
+            while (true) {
+                bool got_tree = false;
+                size_t my_tid = 0;
+#ifdef _OPENMP
+#pragma omp critical(evaluate_trees_input)
+#endif
+                {
+                    for (; read_index < distinct_ids.size() && distinct_ids[read_index] >= 0; read_index++)
+                        skipTree(in);
+                    if (read_index < distinct_ids.size()) {
+                        thread_tree->freeNode();
+                        thread_tree->readTree(in, thread_tree->rooted);
+                        read_index++;
+                        my_tid = read_tid++;
+                        got_tree = true;
+                    }
+                }
+                if (!got_tree)
+                    break;
+                evaluateTree(thread_tree, params);
+                double logl = thread_tree->getCurScore();
+                ostringstream ostr;
+                thread_tree->printTree(ostr);
+                tree_strings[my_tid] = ostr.str();
+                tree_precisions[my_tid] = ostr.precision();
+                info[my_tid].logl = logl;
+                if (orig_tree_lh)
+                    orig_tree_lh[my_tid] = logl;
+                if (pattern_lhs) {
+                    double *my_pattern_lh = pattern_lhs + my_tid*maxnptn;
+                    memset(my_pattern_lh, 0, maxnptn*sizeof(double));
+                    thread_tree->computePatternLikelihood(my_pattern_lh, &logl);
+                } else if (params.print_site_lh) {
+                    tree_site_lhs[my_tid].resize(maxnptn, 0.0);
+                    thread_tree->computePatternLikelihood(tree_site_lhs[my_tid].data(), &logl);
+                }
+#ifdef _OPENMP
+#pragma omp critical(evaluate_trees_output)
+#endif
+                {
+                    tree_done[my_tid] = true;
+                    for (; write_index < distinct_ids.size(); write_index++) {
+                        if (distinct_ids[write_index] >= 0) {
+                            cout << "Tree " << write_index + 1 << " / identical to tree " << distinct_ids[write_index]+1 << endl;
+                            continue;
+                        }
+                        if (!tree_done[write_tid])
+                            break;
+                        treeout << "[ tree " << write_index+1 << " lh=" << info[write_tid].logl << " ]";
+                        treeout << tree_strings[write_tid];
+                        treeout.precision(tree_precisions[write_tid]);
+                        treeout << endl;
+                        tree_strings[write_tid].clear();
+                        if (params.print_tree_lh)
+                            scoreout << info[write_tid].logl << endl;
+                        cout << "Tree " << write_index + 1 << " / LogL: " << info[write_tid].logl << endl;
+                        if (params.print_site_lh) {
+                            string tree_name = "Tree" + convertIntToString(write_index+1);
+                            if (pattern_lhs)
+                                printSiteLh(site_lh_file.c_str(), tree, pattern_lhs + write_tid*maxnptn, true, tree_name.c_str());
+                            else {
+                                printSiteLh(site_lh_file.c_str(), tree, tree_site_lhs[write_tid].data(), true, tree_name.c_str());
+                                vector<double>().swap(tree_site_lhs[write_tid]);
+                            }
+                        }
+                        write_tid++;
+                    }
+                }
+            }
+            deleteThreadTree(thread_tree);
+        }
+        tid = read_tid;
+    } else
     for (tree_index = 0, tid = 0; tree_index < distinct_ids.size(); tree_index++) {
         
         cout << "Tree " << tree_index + 1;
         if (distinct_ids[tree_index] >= 0) {
             cout << " / identical to tree " << distinct_ids[tree_index]+1 << endl;
             // ignore tree
-            char ch;
-            do {
-                in >> ch;
-            } while (!in.eof() && ch != ';');
+            skipTree(in);
             continue;
         }
         tree->freeNode();
         tree->readTree(in, tree->rooted);
-        if (!tree->findNodeName(tree->aln->getSeqName(0))) {
-            outError("Taxon " + tree->aln->getSeqName(0) + " not found in tree");
-        }
-        
-        if (tree->rooted && tree->getModelFactory()->isReversible()) {
-            if (tree->leafNum != tree->aln->getNSeq()+1)
-                outError("Tree does not have same number of taxa as alignment");
-            tree->convertToUnrooted();
-//            cout << "convertToUnrooted" << endl;
-        } else if (!tree->rooted && !tree->getModelFactory()->isReversible()) {
-            if (tree->leafNum != tree->aln->getNSeq())
-                outError("Tree does not have same number of taxa as alignment");
-            tree->convertToRooted();
-//            cout << "convertToRooted" << endl;
-        }
-        tree->setAlignment(tree->aln);
-        tree->setRootNode(params.root);
-        if (tree->isSuperTree())
-            ((PhyloSuperTree*) tree)->mapTrees();
-        
-        tree->initializeAllPartialLh();
-        tree->fixNegativeBranch(false);
-        if (params.fixed_branch_length) {
-            tree->setCurScore(tree->computeLikelihood());
-        } else if (params.topotest_optimize_model) {
-            tree->getModelFactory()->optimizeParameters(BRLEN_OPTIMIZE, false, params.modelEps);
-            tree->setCurScore(tree->computeLikelihood());
-        } else {
-            tree->setCurScore(tree->optimizeAllBranches(100, 0.001));
-        }
+        evaluateTree(tree, params);
         treeout << "[ tree " << tree_index+1 << " lh=" << tree->getCurScore() << " ]";
         tree->printTree(treeout);
         treeout << endl;
@@ -1224,7 +1401,7 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
             double curScore = tree->getCurScore();
             memset(pattern_lh, 0, maxnptn*sizeof(double));
             tree->computePatternLikelihood(pattern_lh, &curScore);
-            if (params.do_weighted_test || params.do_au_test)
+            if (pattern_lhs)
                 memcpy(pattern_lhs + tid*maxnptn, pattern_lh, maxnptn*sizeof(double));
         }
         if (params.print_site_lh) {
@@ -1241,22 +1418,48 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
             tid++;
             continue;
         }
-        // now compute RELL scores
         orig_tree_lh[tid] = tree->getCurScore();
-        double *tree_lhs_offset = tree_lhs + (tid*params.topotest_replicates);
-        for (size_t boot = 0; boot < params.topotest_replicates; boot++) {
-            double lh = 0.0;
-            int *this_boot_sample = boot_samples + (boot*nptn);
-            for (size_t ptn = 0; ptn < nptn; ptn++)
-                lh += pattern_lh[ptn] * this_boot_sample[ptn];
-            tree_lhs_offset[boot] = lh;
-        }
         tid++;
     }
     
     ASSERT(tid == ntrees);
     
     if (params.topotest_replicates && ntrees > 1) {
+        // now compute RELL scores, generating the bootstrap replicates block by block
+        size_t nboot = params.topotest_replicates;
+        size_t block_size = getReplicateBlockSize(nboot, maxnptn);
+        cout << "Computing RELL scores for " << nboot << " bootstrap replicates..." << endl;
+        // replicates are drawn serially from one stream, so they do not depend on the
+        // number of threads; each block is then scored by one (multithreaded) matrix product
+#ifdef _OPENMP
+        int *rstream;
+        init_random(params.ran_seed, false, &rstream);
+#else
+        int *rstream = randstream;
+#endif
+        int *boot_sample = aligned_alloc<int>(maxnptn);
+        double *boot_weights = aligned_alloc<double>(block_size*maxnptn);
+        for (size_t block_start = 0; block_start < nboot; block_start += block_size) {
+            size_t block_end = min(block_start + block_size, nboot);
+            for (size_t boot = block_start; boot < block_end; boot++) {
+                if (boot == 0)
+                    tree->aln->getPatternFreq(boot_sample);
+                else
+                    tree->aln->createBootstrapAlignment(boot_sample, params.bootstrap_spec, rstream);
+                double *this_weights = boot_weights + (boot-block_start)*maxnptn;
+                for (size_t ptn = 0; ptn < nptn; ptn++)
+                    this_weights[ptn] = boot_sample[ptn];
+            }
+            computeReplicateLh(pattern_lhs, ntrees, boot_weights, block_end-block_start,
+                               nptn, maxnptn, tree_lhs + block_start, nboot);
+        }
+        aligned_free(boot_weights);
+        aligned_free(boot_sample);
+#ifdef _OPENMP
+        finish_random(rstream);
+#endif
+        cout << "done" << endl;
+
         double *tree_probs = new double[ntrees];
         memset(tree_probs, 0, ntrees*sizeof(double));
         int *tree_ranks = new int[ntrees];
@@ -1478,7 +1681,6 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
     aligned_free(pattern_lhs);
     delete [] lhdiff_weights;
     delete [] tree_lhs;
-    delete [] boot_samples;
     
     if (params.print_tree_lh) {
         scoreout.close();
@@ -323,22 +323,34 @@ void ModelPoMo::computeStateFreq () {
 void ModelPoMo::updatePoMoStatesAndRateMatrix () {
     computeStateFreq();
 
-    // Compute rate matrix.
+    // Compute rate matrix.  Only the non-zero entries given by
+    // computeProbBoundaryMutation() are set, in increasing column order so
+    // that the row sums are the same as over the full rows.
     int i, j;
+    int k, a, b;
     double tot_sum = 0.0;
+    memset(rates, 0, sizeof(double)*num_states*num_states);
     for (i = 0; i < num_states; i++) {
         double row_sum = 0.0;
-        // Loop over columns in row state1 (transition to state2).
-        for (j = 0; j < num_states; j++)
-            if (i != j) {
-                row_sum +=
-                    (rates[i*num_states+j] =
-                     computeProbBoundaryMutation(i, j));
+        decomposeState(i, k, a, b);
+        if (isBoundary(i)) {
+            // e.g.: 10A -> 9A1C or 10G -> 1A9G
+            for (b = 0; b < n_alleles; b++) {
+                if (b == a)
+                    continue;
+                j = (a < b) ? composePolyState(N-1, a, b) : composePolyState(1, b, a);
+                row_sum += (rates[i*num_states+j] = mutation_rate_matrix[a*n_alleles+b]);
             }
+        } else {
+            // e.g.: 2A8C -> 3A7C and 2A8C -> 1A9C, or 9A1C -> 10A and 1A9C -> 10C
+            double drift = double(k*(N-k)) / double(N);
+            rates[i*num_states+((k == 1) ? b : i-1)] = drift;
+            rates[i*num_states+((k == N-1) ? a : i+1)] = drift;
+            row_sum = drift + drift;
+        }
         tot_sum += state_freq[i]*row_sum;
         // diagonal will be handled later, should not assign now
         //rates[i*num_states+i] = -(row_sum);
-        rates[i*num_states+i] = 0.0;
     }
     // Thu Aug 17 16:11:19 BST 2017; Dom. Normalization is preferred. Then,
     // branch lengths can be interpreted in an easy way (the length equals the
@@ -405,6 +417,13 @@ void ModelPoMo::decomposeState(int state, int &i, int &nt1, int &nt2) {
     }
 }
 
+int ModelPoMo::composePolyState(int i, int nt1, int nt2) {
+    ASSERT(i > 0 && i < N && nt1 < nt2);
+    // index of the allele pair in the order AC, AG, AT, CG, CT, GT
+    int k = (nt1 == 0) ? nt2-1 : nt1+nt2;
+    return 3 + k*(N-1) + i;
+}
+
 bool ModelPoMo::isBoundary(int state) {
     return (state < 4);
 }
@@ -128,6 +128,10 @@ class ModelPoMo : virtual public ModelMarkov
 
     /**
      * Initialize rate_matrix and state_freq for boundary mutation model.
+     * The rate matrix is sparse: each polymorphic state only changes by drift
+     * to its two neighbours and each boundary state only mutates to the
+     * polymorphic states with one copy of another allele, so only these
+     * entries are computed.
      */
     void updatePoMoStatesAndRateMatrix();
 
@@ -383,6 +387,16 @@ class ModelPoMo : virtual public ModelMarkov
      */
     void decomposeState(int state, int &i, int &nt1, int &nt2);
 
+    /**
+     * Compose the polymorphic state with i copies of nucleotide nt1 and N-i
+     * copies of nucleotide nt2 (inverse of decomposeState()).
+     *
+     * @param i Abundance of nucleotide 1 (1..N-1).
+     * @param nt1 Nucleotide 1, nt1 < nt2.
+     * @param nt2 Nucleotide 2.
+     */
+    int composePolyState(int i, int nt1, int nt2);
+
     /**
      * Compute the normalized stationary frequencies that fulfill the
      * detailed balance condition.
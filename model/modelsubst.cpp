@@ -185,12 +185,19 @@ void ModelSubst::multiplyWithInvEigenvector(double *state_lk) {
     double saved_state_lk[num_states];
     memcpy(saved_state_lk, state_lk, sizeof(double)*num_states);
     memset(state_lk, 0, sizeof(double)*num_states*nmixtures);
+    // tip likelihoods are mostly sparse (e.g. a single state, or one allele
+    // pair for PoMo), so only multiply with the columns of non-zero entries
+    int nonzero[num_states];
+    int num_nonzero = 0;
+    for (int j = 0; j < num_states; j++)
+        if (saved_state_lk[j] != 0.0)
+            nonzero[num_nonzero++] = j;
     for (int m = 0; m < nmixtures; m++) {
         double *inv_evec = &inv_eigenvectors[m*num_states*num_states];
         double *this_state_lk = &state_lk[m*num_states];
-        for (int i = 0; i < num_states; i++)
-            for (int j = 0; j < num_states; j++, inv_evec++)
-              this_state_lk[i] += (*inv_evec) * saved_state_lk[j];
+        for (int i = 0; i < num_states; i++, inv_evec += num_states)
+            for (int j = 0; j < num_nonzero; j++)
+              this_state_lk[i] += inv_evec[nonzero[j]] * saved_state_lk[nonzero[j]];
     }
 }
 
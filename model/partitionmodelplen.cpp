@@ -98,22 +98,14 @@ double PartitionModelPlen::optimizeParameters(int fixed_len, bool write_info, do
     double begin_time = getRealTime();
     int i;
     for(i = 1; i < tree->params->num_param_iterations; i++){
-        cur_lh = 0.0;
-        if (tree->part_order.empty()) tree->computePartitionOrder();
-#ifdef _OPENMP
-#pragma omp parallel for reduction(+: cur_lh) schedule(dynamic) if(tree->num_threads > 1)
-#endif
-        for (int partid = 0; partid < ntrees; partid++) {
-            int part = tree->part_order[partid];
+        cur_lh = tree->sumOverPartitions([&](int part) -> double {
             // Subtree model parameters optimization
             tree->part_info[part].cur_score = tree->at(part)->getModelFactory()->
                 optimizeParametersOnly(i+1, gradient_epsilon/min(min(i,ntrees),10),
                                        tree->part_info[part].cur_score);
             if (tree->part_info[part].cur_score == 0.0)
                 tree->part_info[part].cur_score = tree->at(part)->computeLikelihood();
-            cur_lh += tree->part_info[part].cur_score;
-            
-            
+
             // normalize rates s.t. branch lengths are #subst per site
             double mean_rate = tree->at(part)->getRate()->rescaleRates();
             if (fabs(mean_rate-1.0) > 1e-6) {
@@ -123,8 +115,8 @@ double PartitionModelPlen::optimizeParameters(int fixed_len, bool write_info, do
                 tree->at(part)->scaleLength(mean_rate);
                 tree->part_info[part].part_rate *= mean_rate;
             }
-            
-        }
+            return tree->part_info[part].cur_score;
+        });
         if (tree->params->link_alpha) {
             cur_lh = optimizeLinkedAlpha(write_info, gradient_epsilon);
         }
@@ -228,13 +220,7 @@ double PartitionModelPlen::optimizeGeneRate(double gradient_epsilon)
             }
         }
     }
-    if (tree->part_order.empty()) tree->computePartitionOrder();
-    
-#ifdef _OPENMP
-#pragma omp parallel for reduction(+: score) schedule(dynamic) if(tree->num_threads > 1)
-#endif
-    for (int j = 0; j < tree->size(); j++) {
-        int i = tree->part_order[j];
+    score = tree->sumOverPartitions([&](int i) -> double {
         double min_scaling = 1.0/tree->at(i)->getAlnNSite();
         double max_scaling = nsites / tree->at(i)->getAlnNSite();
         if (max_scaling < tree->part_info[i].part_rate)
@@ -242,8 +228,8 @@ double PartitionModelPlen::optimizeGeneRate(double gradient_epsilon)
         if (min_scaling > tree->part_info[i].part_rate)
             min_scaling = tree->part_info[i].part_rate;
         tree->part_info[i].cur_score = tree->at(i)->optimizeTreeLengthScaling(min_scaling, tree->part_info[i].part_rate, max_scaling, gradient_epsilon);
-        score += tree->part_info[i].cur_score;
-    }
+        return tree->part_info[i].cur_score;
+    });
     // now normalize the rates
     double sum = 0.0;
     size_t nsite = 0;
@@ -477,6 +477,13 @@ void PDNetwork::findPD(Params &params, vector<SplitSet> &taxa_set, vector<int> &
 		cout << "Linear programming on general split network..." << endl;
 		findPD_LP(params, taxa_set);
 	} 
+	else if (params.num_threads > 1) {
+		// exhaustive search by the order, subtrees in parallel
+		cout << endl << "Start exhaustive search with " << params.num_threads << " threads..." << endl;
+		taxa_set.resize(1);
+		taxa_set[0].push_back(new Split(ntaxa, 0.0));
+		exhaustPDParallel(params, taxa_set[0], taxa_order);
+	}
 	else if (isBudgetConstraint()) {
 		// exhaustive search by the order
 		cout << endl << "Start exhaustive search..." << endl;
@@ -579,6 +586,86 @@ double PDNetwork::exhaustPDBudget(int cur_budget, int cur_tax, Split &curset,
 }
 
 
+void PDNetwork::exhaustPDParallel(Params &params, SplitSet &best_set, vector<int> &taxa_order) {
+	int ntaxa = getNTaxa();
+	int nsplits = getNSplits();
+	bool budget_constraint = isBudgetConstraint();
+	int num_first = budget_constraint ? ntaxa : ntaxa - params.sub_size + 1;
+	if (num_first <= 0)
+		return;
+	// best sets found below each first taxon, merged in taxa_order afterwards
+	vector<SplitSet> first_best(num_first);
+	// best PD score found so far by any thread, shared to skip storing inferior sets
+	double incumbent = best_set[0]->weight;
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+	{
+		// each thread owns its current set and list of remaining splits
+		Split curset(ntaxa, 0.0);
+		IntList rem_splits;
+		for (int i = 0; i < nsplits; i++)
+			rem_splits.push_back(i);
+		IntList::iterator rem_it = rem_splits.end();
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+		for (int tax = 0; tax < num_first; tax++) {
+			int taxon = taxa_order[tax];
+			if (budget_constraint && pda->costs[taxon] > params.budget)
+				continue;
+			SplitSet &tax_best = first_best[tax];
+			double bound;
+#ifdef _OPENMP
+#pragma omp critical(pd_incumbent)
+#endif
+			bound = incumbent;
+			// the empty set carries the incumbent score and is dropped when merging
+			tax_best.push_back(new Split(ntaxa, bound));
+
+			curset.addTaxon(taxon);
+			curset.weight = calcRaisedWeight(curset, rem_splits, rem_it);
+			if (budget_constraint) {
+				if (curset.weight >= tax_best[0]->weight)
+					updateSplitVector(curset, tax_best);
+				if (tax < ntaxa-1)
+					exhaustPDBudget(params.budget - pda->costs[taxon], tax,
+						curset, params.find_all, tax_best, taxa_order, rem_splits, rem_it);
+			} else if (params.sub_size > 1) {
+				exhaustPD2(params.sub_size-1, tax, curset, params.find_all, tax_best, taxa_order, rem_splits, rem_it);
+			} else if (curset.weight >= tax_best[0]->weight) {
+				updateSplitVector(curset, tax_best);
+			}
+			curset.removeTaxon(taxon);
+			curset.weight = 0.0;
+			rem_it = rem_splits.end();
+#ifdef _OPENMP
+#pragma omp critical(pd_incumbent)
+#endif
+			if (tax_best[0]->weight > incumbent)
+				incumbent = tax_best[0]->weight;
+		}
+	}
+
+	// keep all sets with the overall maximal PD, in the same order as the sequential search
+	double best_weight = incumbent;
+	if (best_weight > best_set[0]->weight) {
+		for (int it = best_set.size()-1; it >= 0; it--)
+			delete best_set[it];
+		best_set.clear();
+	}
+	for (int tax = 0; tax < num_first; tax++) {
+		for (SplitSet::iterator it = first_best[tax].begin(); it != first_best[tax].end(); it++)
+			if ((*it)->weight == best_weight && !(*it)->isEmpty())
+				best_set.push_back(*it);
+			else
+				delete (*it);
+		first_best[tax].clear();
+	}
+}
+
 /********************************************************
 	GREEDY SEARCH!
 ********************************************************/
@@ -345,6 +345,15 @@ protected:
 		bool find_all,SplitSet &best_set, vector<int> &taxa_order, 
 		IntList &rem_splits, IntList::iterator &rem_it);
 
+	/**
+		exhaustive search for maximal PD of size params.sub_size or within params.budget,
+		the subtrees rooted at the first taxon in taxa_order are searched in parallel
+		@param params program parameters
+		@param best_set (IN/OUT) the set of taxa in the maximal PD set, initially the empty set
+		@param taxa_order (IN) order of inserted taxa
+	*/
+	void exhaustPDParallel(Params &params, SplitSet &best_set, vector<int> &taxa_order);
+
 	/**
 		calculate sum of weights of preserved splits in the taxa_set
 		@param taxa_set a set of taxa
@@ -21,6 +21,18 @@
  ***************************************************************************/
 #include "split.h"
 
+#if defined (__GNUC__) || defined(__clang__)
+#define split_popcnt __builtin_popcount
+#else
+static inline UINT split_popcnt(UINT a) {
+    UINT b = a - ((a >> 1) & 0x55555555);
+    UINT c = (b & 0x33333333) + ((b >> 2) & 0x33333333);
+    UINT d = (c + (c >> 4)) & 0x0F0F0F0F;
+    UINT e = d * 0x01010101;
+    return e >> 24;
+}
+#endif
+
 Split::Split()
 		: vector<UINT>()
 {
@@ -122,13 +134,13 @@ void Split::setNTaxa(int antaxa)
 }
 
 int Split::countTaxa() const {
-	int count=0;
-	for (int i = 0; i < size(); i++)
-		for (UINT j = 0; j < UINT_BITS && (i*UINT_BITS+j < getNTaxa()); j++)
-			if ((*this)[i] & (1 << j))
-			{
-				count++;
-			}
+	int count = 0;
+	int full_words = min((int)size(), ntaxa / UINT_BITS);
+	for (int i = 0; i < full_words; i++)
+		count += split_popcnt((*this)[i]);
+	// mask out the unused bits of the last word
+	if (full_words < (int)size() && ntaxa % UINT_BITS != 0)
+		count += split_popcnt((*this)[full_words] & ((1U << (ntaxa % UINT_BITS)) - 1));
 	return count;
 }
 
@@ -136,8 +148,8 @@ void Split::report(ostream &out)
 {
 
 	out << getWeight() << '\t';
-	for (int i = 0; i < size(); i++)
-		for (UINT j = 0; j < UINT_BITS && (i*UINT_BITS+j < getNTaxa()); j++)
+	for (int i = 0; i < (int)size(); i++)
+		for (int j = 0; j < UINT_BITS && (i*UINT_BITS+j < getNTaxa()); j++)
 			if ((*this)[i] & (1 << j))
 			{
 				//out << i * UINT_BITS + j + 1 << " ";
@@ -148,9 +160,9 @@ void Split::report(ostream &out)
 
 
 int Split::firstTaxon() {
-	for (int i = 0; i < size(); i++)
+	for (int i = 0; i < (int)size(); i++)
 		if ((*this)[i] != 0) {
-			for (UINT j = 0; j < UINT_BITS && (i*UINT_BITS+j < getNTaxa()); j++)
+			for (int j = 0; j < UINT_BITS && (i*UINT_BITS+j < getNTaxa()); j++)
 				if ((*this)[i] & (1 << j)) {
 					return (i * UINT_BITS + j);
 				}
@@ -242,40 +254,21 @@ int Split::trivial() {
 		// not a trivial split
 		return -1;
 */
-	int id0 = 0, id1 = 0, pos = 0;
-	int bit0s = 0, bit1s = 0;
+	// count the taxa by popcount, then only locate the single taxon of a trivial split
+	int bit1s = countTaxa();
+	if (bit1s != 1 && bit1s != ntaxa - 1)
+		return -1;
+	bool find_one = (bit1s == 1);
+	int pos = 0;
 	for (iterator it = begin(); it != end(); it++, pos++) {
-		UINT content = *it;
-		int max_step;
-		if ((it + 1) == end()) {
-			max_step = ntaxa % UINT_BITS;
-			if (!max_step) max_step = UINT_BITS;
-		}
-		else
-			max_step = UINT_BITS;
-
-		for (int i = 0; i < max_step; i++) {
-			if ((content & ( 1 << i)) != 0) {
-				bit1s ++;
-				if (bit1s == 1) 
-					id1 = pos * UINT_BITS + i;
-			}
-			else {
-				bit0s ++;
-				if (bit0s == 1) 
-					id0 = pos * UINT_BITS + i;
-			}
-			// if both number of bit 0 and 1 greater than 1, return -1 (not trivial)
-			if (bit1s > 1 && bit0s > 1) 
-				return -1;
-		}
+		UINT content = find_one ? *it : ~(*it);
+		if (content == 0)
+			continue;
+		for (int i = 0; i < UINT_BITS && pos * UINT_BITS + i < ntaxa; i++)
+			if ((content & (1U << i)) != 0)
+				return pos * UINT_BITS + i;
 	}
-	if (bit1s == 1)
-		return id1;
-	else if (bit0s == 1)
-		return id0;
-	else
-		return -1;
+	return -1;
 }
 
 
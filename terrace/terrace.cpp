@@ -10,10 +10,12 @@
 #include "terracenode.hpp"
 #include "tree/mtreeset.h"
 #include "utils/timeutil.h"
+#include "utils/gzstream.h"
 
 Terrace::Terrace(){};
 Terrace::~Terrace(){
 
+    close_terrace_trees_file();
     for(vector<TerraceTree*>::reverse_iterator it=induced_trees.rbegin(); it<induced_trees.rend();it++){
         delete (*it);
     }
@@ -1144,7 +1146,17 @@ void Terrace::generateTerraceTrees(Terrace *terrace, vector<Terrace*> &part_tree
     
     int j, id;
     
-    if(!node1_vec_branch.empty()){
+    // INFO: for the last taxon every allowed branch yields a tree from the stand. If the trees are not written, it is enough to count them without inserting the taxon.
+    bool count_only = (taxon_to_insert == list_taxa_to_insert.size()-1) && !(terrace_out && (trees_out_lim==0 or terrace_trees_num<trees_out_lim));
+    
+    if(count_only && !node1_vec_branch.empty()){
+        unsigned int num_trees = node1_vec_branch.size();
+        if(num_trees >= terrace_max_trees - terrace_trees_num){
+            terrace_trees_num = terrace_max_trees;
+            write_warning_stop(2);
+        }
+        terrace_trees_num += num_trees;
+    } else if(!node1_vec_branch.empty()){
         //cout<<"NUM_OF_ALLOWED_BRANCHES_"<<taxon_name<<"_"<<node1_vec_branch.size()<<"\n";
         //cout<<"ALL ALLOWED BRANCHES:"<<"\n";
         //for(j=0; j<node1_vec_branch.size(); j++){
@@ -1173,7 +1185,7 @@ void Terrace::generateTerraceTrees(Terrace *terrace, vector<Terrace*> &part_tree
                     //ofstream out;
                     //out.exceptions(ios::failbit | ios::badbit);
                     //out.open(out_file,std::ios_base::app);
-                    printTree(out, WT_BR_SCALE | WT_NEWLINE);
+                    printTree(*out, WT_BR_SCALE | WT_NEWLINE);
                     //out.close();
                     }
                 }
@@ -1615,6 +1627,35 @@ void Terrace::write_terrace_trees_to_file(){
 
 }
 
+void Terrace::open_terrace_trees_file(bool compress){
+    
+    close_terrace_trees_file();
+    if(compress){
+        out_file += ".gz";
+        out = new ogzstream(out_file.c_str());
+    }else{
+        out = new ofstream(out_file.c_str());
+    }
+    if(!out->good()){
+        outError(ERR_WRITE_OUTPUT, out_file);
+    }
+    out->exceptions(ios::failbit | ios::badbit);
+}
+
+void Terrace::close_terrace_trees_file(){
+    
+    if(!out){
+        return;
+    }
+    if(ogzstream *gz_out = dynamic_cast<ogzstream*>(out)){
+        gz_out->close();
+    }else{
+        ((ofstream*)out)->close();
+    }
+    delete out;
+    out = nullptr;
+}
+
 void Terrace::write_summary_generation(){
 
     //Params::getInstance().run_time = (getCPUTime() - Params::getInstance().startCPUTime);
@@ -1635,9 +1676,7 @@ void Terrace::write_summary_generation(){
     if(master_terrace->root){
         if(terrace_trees_num==0 && rm_leaves==-1){
             
-            if(terrace_out){
-                out.close();
-            }
+            close_terrace_trees_file();
             cout<<"Current wall-clock time used: "<<getRealTime()-Params::getInstance().start_real_time<<" seconds ("<<convert_time(getRealTime()-Params::getInstance().start_real_time)<<")"<<"\n";
             cout<<"Current CPU time used: "
             << getCPUTime()-Params::getInstance().startCPUTime << " seconds (" << convert_time(getCPUTime()-Params::getInstance().startCPUTime) << ")" << "\n";
@@ -1658,7 +1697,7 @@ void Terrace::write_summary_generation(){
     }
     
     if(terrace_out){
-        out.close();
+        close_terrace_trees_file();
         //write_terrace_trees_to_file();
         //cout<<"---------------------------------------------------------"<<"\n";
     }
@@ -90,7 +90,7 @@ public:
     
     // file to output all generated terrace trees
     string out_file;
-    ofstream out;
+    ostream *out{nullptr};
     bool terrace_out;
     int trees_out_lim;
     
@@ -220,6 +220,16 @@ public:
      */
     void write_terrace_trees_to_file();
     
+    /*
+     *  Open out_file for streaming the generated trees, gzip-compressed if compress is true
+     */
+    void open_terrace_trees_file(bool compress);
+    
+    /*
+     *  Flush and close the file with generated trees
+     */
+    void close_terrace_trees_file();
+    
     /*
      *  Write summary of generating trees from a terrace
      */
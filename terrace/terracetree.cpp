@@ -22,11 +22,7 @@ TerraceTree::~TerraceTree(){
             brNodes.erase(id);
         }
     }
-    if(leafNodes.size()>0){
-        for(auto t=leafNodes.begin(); t!=leafNodes.end();t++){
-            leafNodes.erase(t);
-        }
-    }
+    leafNodes.clear();
 
     if (root != NULL)
         freeNode();
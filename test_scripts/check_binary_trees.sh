@@ -0,0 +1,25 @@
+#!/bin/bash
+# Check the binary tree-set format: a consensus built from UFBoot trees written
+# with --boot-trees-bin must equal the one built from the same trees in NEWICK.
+#
+# USAGE: check_binary_trees.sh <iqtree2_binary> <test_data_dir>
+
+source "$(dirname "$0")/check_common.sh"
+
+run_iqtree -s "$DATA/example.phy" -m JC -B 1000 -wbtl -seed 1 -pre newick
+run_iqtree -s "$DATA/example.phy" -m JC -B 1000 -wbtl --boot-trees-bin 64 -seed 1 -pre binary
+[ -f binary.ufboot.bin ] || fail "no .ufboot.bin file written"
+cmp -s newick.contree binary.contree || fail "UFBoot consensus differs with --boot-trees-bin"
+
+# consensus of the tree files, also with burnin
+for burnin in 0 5; do
+    run_iqtree -con -t newick.ufboot -bi $burnin -pre con_newick
+    run_iqtree -con -t binary.ufboot.bin -bi $burnin -pre con_binary
+    cmp -s con_newick.contree con_binary.contree || fail "-con -bi $burnin: consensus of .ufboot.bin differs"
+done
+
+# a truncated file must be reported, not read
+head -c 5000 binary.ufboot.bin > truncated.bin
+"$IQTREE" -con -t truncated.bin -pre con_truncated 2>&1 | grep -q "truncated" ||
+    fail "truncated binary tree file not reported"
+exit 0
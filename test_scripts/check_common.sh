@@ -0,0 +1,41 @@
+# Common setup of the check_*.sh scripts, which run iqtree2 on small examples
+# and compare its output. They are registered with ctest in CMakeLists.txt.
+#
+# USAGE: source check_common.sh <iqtree2_binary> <test_data_dir>
+
+IQTREE=$1
+DATA=$2
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK" || exit 1
+
+# exit code for ctest to report a test as skipped
+SKIP=77
+
+fail() {
+    echo "FAILED: $*" >&2
+    exit 1
+}
+
+# run iqtree2 quietly, failing the check if it does
+run_iqtree() {
+    "$IQTREE" "$@" > /dev/null 2>&1 || fail "iqtree2 $*"
+}
+
+# number of threads for multithreaded runs: up to 4, but no more than the CPUs
+max_threads() {
+    local n=$(nproc 2>/dev/null || echo 1)
+    [ "$n" -gt 4 ] && n=4
+    echo "$n"
+}
+
+# run iqtree2 with the given number of threads, skipping the check
+# if iqtree2 detects fewer CPU cores
+run_iqtree_threads() {
+    local threads=$1
+    shift
+    if ! "$IQTREE" -T "$threads" "$@" > threads.out 2>&1; then
+        grep -q "more threads than CPU cores" threads.out && exit $SKIP
+        fail "iqtree2 -T $threads $*"
+    fi
+}
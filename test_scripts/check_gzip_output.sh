@@ -0,0 +1,16 @@
+#!/bin/bash
+# Check that -gz writes the same ancestral states (--ancestral), only gzip-compressed.
+#
+# USAGE: check_gzip_output.sh <iqtree2_binary> <test_data_dir>
+
+source "$(dirname "$0")/check_common.sh"
+
+run_iqtree -s "$DATA/example.phy" -m JC -n 0 -seed 1 --ancestral -pre plain
+run_iqtree -s "$DATA/example.phy" -m JC -n 0 -seed 1 --ancestral -gz -pre compressed
+[ -f plain.state ] || fail "no .state file written"
+[ -f compressed.state.gz ] || fail "no .state.gz file written with -gz"
+[ -f compressed.state ] && fail ".state file written with -gz"
+# the header comments name the output files, which differ
+gzip -dc compressed.state.gz | grep -v "^#" | cmp -s <(grep -v "^#" plain.state) - ||
+    fail ".state.gz differs from .state"
+exit 0
@@ -0,0 +1,32 @@
+#!/bin/bash
+# Check that bounding the Fitch branch scores during stepwise addition does not
+# change the -t PARS tree. The expected scores were obtained with the bound
+# disabled; the trees must not depend on the kernel or on the number of threads.
+#
+# USAGE: check_parsimony_bound.sh <iqtree2_binary> <test_data_dir>
+
+source "$(dirname "$0")/check_common.sh"
+
+# check_alignment ALIGNMENT MODEL EXPECTED_SCORE
+check_alignment() {
+    local name=$(basename "$1" .phy)
+    # SSE kernels, then the best kernels for this CPU (-lk x86 has no likelihood
+    # kernels in SIMD builds)
+    for lk in SSE best; do
+        local lk_option="-lk $lk"
+        [ $lk = best ] && lk_option=
+        run_iqtree -s "$DATA/$1" -m "$2" -t PARS -n 0 -seed 1 $lk_option -pre $name.$lk
+        local score=$(sed -n 's/.*parsimony score: \([0-9]*\).*/\1/p' $name.$lk.log)
+        [ "$score" = "$3" ] || fail "$1 with -lk $lk: parsimony score $score, expected $3"
+        cmp -s $name.SSE.parstree $name.$lk.parstree || fail "$1: -lk $lk tree differs from -lk SSE"
+    done
+    local threads=$(max_threads)
+    if [ "$threads" -gt 1 ]; then
+        run_iqtree_threads $threads -s "$DATA/$1" -m "$2" -t PARS -n 0 -seed 1 -pre $name.T$threads
+        cmp -s $name.SSE.parstree $name.T$threads.parstree || fail "$1: -T $threads tree differs from -T 1"
+    fi
+}
+
+check_alignment d59_8.phy JC 8826
+check_alignment prot_M126_27_269.phy LG 846
+exit 0
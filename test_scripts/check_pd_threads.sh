@@ -0,0 +1,19 @@
+#!/bin/bash
+# Check that the exhaustive PD search on a split network (-exhaust) finds the
+# same optimal sets, in the same order, with one and with several threads.
+#
+# USAGE: check_pd_threads.sh <iqtree2_binary> <test_data_dir>
+
+source "$(dirname "$0")/check_common.sh"
+
+threads=$(max_threads)
+[ "$threads" -gt 1 ] || exit $SKIP
+
+# subset size k, then a budget
+for pd_option in "-k 6" "-u $DATA/pd_budget.txt"; do
+    run_iqtree "$DATA/pd_network.nex" $pd_option -exhaust -T 1 -pre serial
+    run_iqtree_threads $threads "$DATA/pd_network.nex" $pd_option -exhaust -pre parallel
+    diff -q <(grep -iv "time" serial.pda) <(grep -iv "time" parallel.pda) > /dev/null ||
+        fail "$pd_option: -T $threads results differ from -T 1"
+done
+exit 0
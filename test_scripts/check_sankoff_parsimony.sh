@@ -0,0 +1,28 @@
+#!/bin/bash
+# Check the Sankoff parsimony kernels (--mpcost) on -t PARS trees. With uniform
+# costs the scores must equal the Fitch scores, which were obtained with the
+# score bound disabled, and SIMD kernels of each width must give the same trees.
+#
+# USAGE: check_sankoff_parsimony.sh <iqtree2_binary> <test_data_dir>
+
+source "$(dirname "$0")/check_common.sh"
+
+# check_alignment ALIGNMENT MODEL EXPECTED_SCORE
+check_alignment() {
+    local name=$(basename "$1" .phy)
+    # SSE kernels, then the best kernels for this CPU (-lk x86 has no likelihood
+    # kernels in SIMD builds)
+    for lk in SSE best; do
+        local lk_option="-lk $lk"
+        [ $lk = best ] && lk_option=
+        run_iqtree -s "$DATA/$1" -m "$2" --mpcost e -t PARS -n 0 -seed 1 $lk_option -pre $name.$lk
+        local score=$(sed -n 's/.*parsimony score: \([0-9]*\).*/\1/p' $name.$lk.log)
+        [ "$score" = "$3" ] || fail "$1 with -lk $lk: parsimony score $score, expected $3"
+        cmp -s $name.SSE.parstree $name.$lk.parstree || fail "$1: -lk $lk tree differs from -lk SSE"
+    done
+}
+
+# the protein alignment has a pattern count that is not a multiple of the SIMD width
+check_alignment prot_M126_27_269.phy LG 846
+check_alignment example.phy JC 2872
+exit 0
@@ -39,22 +39,26 @@ void PhyloTree::computeSiteConcordance(map<string,string> &meanings) {
     }
 #endif
 
-#if defined(_OPENMP) && (do_openmp == true)
-#pragma omp parallel
-    {
-        int *rstream;
-        init_random(params->ran_seed + omp_get_thread_num(), false, &rstream);
-#pragma omp for
-#else
-        int *rstream = randstream;
+    if (!params->ancestral_site_concordance)
+        aln->buildQuartetSupportColumns();
+
+    // (do_openmp is only known at run time, so it can't be tested by #if)
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if(do_openmp)
 #endif
     for (auto ii = 0; ii < branches.size(); ii++) {
         BranchVector::iterator it = branches.begin()+ii;
         if (params->ancestral_site_concordance)
-            computeAncestralSiteConcordance((*it), params->site_concordance, rstream,
+            computeAncestralSiteConcordance((*it), params->site_concordance, randstream,
                 marginal_ancestral_prob, marginal_ancestral_seq);
-        else
+        else {
+            // each branch has its own random stream (seeded by branch number),
+            // so that sCF does not depend on the number of threads
+            int *rstream;
+            init_random(params->ran_seed + ii, false, &rstream);
             computeSiteConcordance((*it), params->site_concordance, rstream);
+            finish_random(rstream);
+        }
         Neighbor *nei = it->second->findNeighbor(it->first);
         double sCF = 0.0;
         if (!GET_ATTR(nei, sCF))
@@ -76,10 +80,6 @@ void PhyloTree::computeSiteConcordance(map<string,string> &meanings) {
             node->name += sup_str;
         }
     }
-#if defined(_OPENMP) && (do_openmp == true)
-        finish_random(rstream);
-    }
-#endif
 
     if (params->ancestral_site_concordance)
         endMarginalAncestralState(orig_kernel_nonrev, marginal_ancestral_prob, marginal_ancestral_seq);
@@ -93,10 +93,63 @@ void PhyloTree::computeSiteConcordance(map<string,string> &meanings) {
     PUT_MEANING(sDF2_N, "sDF2 in absolute number of sites");
 }
 
+void Alignment::buildQuartetSupportColumns() {
+    quartet_columns.clear();
+    quartet_column_freqs.clear();
+    quartet_columns_built = false;
+    // states are stored a byte each
+    if (num_states >= UCHAR_MAX)
+        return;
+    for (auto pat = begin(); pat != end(); pat++)
+        if (pat->isInformative())
+            quartet_column_freqs.push_back(pat->frequency);
+    size_t ninformative = quartet_column_freqs.size();
+    size_t nseq = getNSeq();
+    quartet_columns.resize(nseq * ninformative);
+    size_t ptn = 0;
+    for (auto pat = begin(); pat != end(); pat++) {
+        if (!pat->isInformative()) continue;
+        for (size_t seq = 0; seq < nseq; seq++) {
+            StateType state = pat->at(seq);
+            quartet_columns[seq*ninformative + ptn] = (state < num_states) ? state : UCHAR_MAX;
+        }
+        ptn++;
+    }
+    quartet_columns_built = true;
+}
+
+void SuperAlignment::buildQuartetSupportColumns() {
+    for (auto part = partitions.begin(); part != partitions.end(); part++)
+        (*part)->buildQuartetSupportColumns();
+}
+
 void Alignment::computeQuartetSupports(IntVector &quartet, vector<int64_t> &support) {
     // sanity check e.g. when having rooted tree
     for (auto q = quartet.begin(); q != quartet.end(); q++)
         ASSERT(*q < getNSeq());
+
+    if (quartet_columns_built) {
+        // scan the four columns of the informative patterns
+        size_t ninformative = quartet_column_freqs.size();
+        if (ninformative == 0)
+            return;
+        const unsigned char *col0 = &quartet_columns[quartet[0]*ninformative];
+        const unsigned char *col1 = &quartet_columns[quartet[1]*ninformative];
+        const unsigned char *col2 = &quartet_columns[quartet[2]*ninformative];
+        const unsigned char *col3 = &quartet_columns[quartet[3]*ninformative];
+        for (size_t ptn = 0; ptn < ninformative; ptn++) {
+            unsigned char s0 = col0[ptn], s1 = col1[ptn], s2 = col2[ptn], s3 = col3[ptn];
+            if (s0 == UCHAR_MAX || s1 == UCHAR_MAX || s2 == UCHAR_MAX || s3 == UCHAR_MAX)
+                continue;
+            if (s0 == s1 && s2 == s3 && s0 != s2)
+                support[0] += quartet_column_freqs[ptn];
+            if (s0 == s2 && s1 == s3 && s0 != s1)
+                support[1] += quartet_column_freqs[ptn];
+            if (s0 == s3 && s1 == s2 && s0 != s1)
+                support[2] += quartet_column_freqs[ptn];
+        }
+        return;
+    }
         
     for (auto pat = begin(); pat != end(); pat++) {
         if (!pat->isInformative()) continue;
@@ -698,6 +751,40 @@ void PhyloTree::computeAllAncestralSiteConcordance() {
 
 }
 
+/**
+ the splits of the gene trees with the same taxon set, for computeGeneConcordance
+ */
+struct GeneTreeSplits {
+    /** taxa of the gene trees (in the species tree numbering) */
+    Split *taxa_mask;
+    /** number of taxa in taxa_mask */
+    int num_taxa;
+    /** the smallest taxon ID in taxa_mask */
+    int first_taxon;
+    /** IDs of the gene trees */
+    IntVector tree_ids;
+    /** split (see normalizeSubSplit) -> number of the gene trees having it */
+    SplitIntMap split_counts;
+    /** the splits in split_counts */
+    vector<Split*> splits;
+};
+
+/**
+ restrict a split to the taxa of some gene trees and normalize it there, as
+ Split::extractSubSplit() followed by Split::invert() (if Split::shouldInvert())
+ would, but keeping the species tree numbering of the taxa
+ */
+static void normalizeSubSplit(Split &sp, GeneTreeSplits &genes) {
+    sp *= *genes.taxa_mask;
+    int count = sp.countTaxa();
+    if (count * 2 < genes.num_taxa)
+        return;
+    if (count * 2 == genes.num_taxa && sp.containTaxon(genes.first_taxon))
+        return;
+    for (size_t i = 0; i < sp.size(); i++)
+        sp[i] = (*genes.taxa_mask)[i] & ~sp[i];
+}
+
 /**
  assign branch supports to a target tree
  */
@@ -717,75 +804,124 @@ void PhyloTree::computeGeneConcordance(MTreeSet &trees, map<string,string> &mean
     supports[1].resize(branches.size(), 0);
     supports[2].resize(branches.size(), 0);
     string prefix[3] = {"gC", "gD1", "gD2"};
+
+    // Gene trees with the same taxon set share one index of their splits,
+    // so that each branch is looked up once per taxon set, rather than once
+    // per gene tree. Per-tree output (site_concordance_partition) needs
+    // every gene tree to be looked up on its own.
+    vector<GeneTreeSplits*> gene_sets;
+    SplitIntMap gene_set_index; // taxa_mask -> index in gene_sets
     int treeid, taxid;
     for (treeid = 0; treeid < trees.size(); treeid++) {
         MTree *tree = trees[treeid];
-        StrVector taxname;
-        tree->getTaxaName(taxname);
+        NodeVector taxa;
+        tree->getTaxa(taxa);
         // create the map from taxa between 2 trees
-        Split taxa_mask(leafNum);
-        for (StrVector::iterator it = taxname.begin(); it != taxname.end(); it++) {
-            if (name_map.find(*it) == name_map.end())
-                outError("Taxon not found in full tree: ", *it);
-            taxa_mask.addTaxon(name_map[*it]);
+        Split *taxa_mask = new Split(leafNum);
+        NodeVector full_taxa(leafNum, NULL); // gene tree leaf of each taxon
+        for (auto it = taxa.begin(); it != taxa.end(); it++) {
+            auto name_it = name_map.find((*it)->name);
+            if (name_it == name_map.end())
+                outError("Taxon not found in full tree: ", (*it)->name);
+            taxa_mask->addTaxon(name_it->second);
+            full_taxa[name_it->second] = *it;
         }
         // make the taxa ordering right before converting to split system
-        taxname.clear();
-        int smallid;
-        for (taxid = 0, smallid = 0; taxid < leafNum; taxid++)
-            if (taxa_mask.containTaxon(taxid)) {
-                taxname.push_back(names[taxid]);
-                tree->findLeafName(names[taxid])->id = smallid++;
+        IntVector full_id; // species tree ID of each gene tree taxon
+        for (taxid = 0; taxid < leafNum; taxid++)
+            if (full_taxa[taxid]) {
+                full_taxa[taxid]->id = full_id.size();
+                full_id.push_back(taxid);
             }
-        ASSERT(taxname.size() == tree->leafNum);
-        
+        ASSERT(full_id.size() == tree->leafNum);
+
+        int gene_set_id = -1;
+        if (!params->site_concordance_partition && gene_set_index.findSplit(taxa_mask, gene_set_id)) {
+            delete taxa_mask;
+        } else {
+            GeneTreeSplits *genes = new GeneTreeSplits;
+            genes->taxa_mask = taxa_mask;
+            genes->num_taxa = full_id.size();
+            genes->first_taxon = full_id[0];
+            gene_set_id = gene_sets.size();
+            gene_sets.push_back(genes);
+            if (!params->site_concordance_partition)
+                gene_set_index.insertSplit(taxa_mask, gene_set_id);
+        }
+        GeneTreeSplits *genes = gene_sets[gene_set_id];
+        genes->tree_ids.push_back(treeid);
+
         SplitGraph sg;
-        //NodeVector nodes;
         tree->convertSplits(sg);
-        SplitIntMap hash_ss;
-        for (auto sit = sg.begin(); sit != sg.end(); sit++)
-            hash_ss.insertSplit((*sit), 1);
-        
-        // now scan through all splits in current tree
-        int id, qid;
-        for (id = 0, qid = 0; qid < subtrees.size(); id++, qid += 4)
-        {
-            Neighbor *nei = branches[id].second->findNeighbor(branches[id].first);
+        for (auto sit = sg.begin(); sit != sg.end(); sit++) {
+            Split *sp;
+            if (genes->num_taxa == leafNum) {
+                // same taxa, same numbering
+                sp = new Split(**sit);
+            } else {
+                sp = new Split(leafNum);
+                for (taxid = 0; taxid < full_id.size(); taxid++)
+                    if ((*sit)->containTaxon(taxid))
+                        sp->addTaxon(full_id[taxid]);
+            }
+            normalizeSubSplit(*sp, *genes);
+            int count;
+            Split *found = genes->split_counts.findSplit(sp, count);
+            if (found) {
+                genes->split_counts.setValue(found, count+1);
+                delete sp;
+            } else {
+                genes->split_counts.insertSplit(sp, 1);
+                genes->splits.push_back(sp);
+            }
+        }
+    }
 
+    // now scan through all branches, each against all gene tree splits
+    int nbranches = branches.size();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int id = 0; id < nbranches; id++) {
+        int qid = id * 4;
+        Neighbor *nei = branches[id].second->findNeighbor(branches[id].first);
+        for (auto git = gene_sets.begin(); git != gene_sets.end(); git++) {
+            GeneTreeSplits *genes = *git;
             bool decisive = true;
             int i;
             for (i = 0; i < 4; i++) {
-                if (!taxa_mask.overlap(*subtrees[qid+i])) {
+                if (!genes->taxa_mask->overlap(*subtrees[qid+i])) {
                     decisive = false;
                     break;
                 }
             }
             if (!decisive && params->site_concordance_partition) {
                 for (i = 0; i < 3; i++)
-                    nei->putAttr(prefix[i] + convertIntToString(treeid+1), "NA");
+                    nei->putAttr(prefix[i] + convertIntToString(genes->tree_ids[0]+1), "NA");
             }
 
             if (!decisive) continue;
-            
-            decisive_counts[id]++;
+
+            decisive_counts[id] += genes->tree_ids.size();
             for (i = 0; i < 3; i++) {
                 Split this_split = *subtrees[qid]; // current split
                 this_split += *subtrees[qid+i+1];
-                Split *subsp = this_split.extractSubSplit(taxa_mask);
-                if (subsp->shouldInvert())
-                    subsp->invert();
-                int concordant = 0;
-                if (hash_ss.findSplit(subsp)) {
-                    supports[i][id]++;
-                    concordant = 1;
-                }
+                normalizeSubSplit(this_split, *genes);
+                int count;
+                genes->split_counts.findSplit(&this_split, count);
+                supports[i][id] += count;
                 if (params->site_concordance_partition) {
-                    nei->putAttr(prefix[i] + convertIntToString(treeid+1), concordant);
+                    int concordant = (count > 0) ? 1 : 0;
+                    nei->putAttr(prefix[i] + convertIntToString(genes->tree_ids[0]+1), concordant);
                 }
-                delete subsp;
             }
         }
-        
+    }
+    for (auto git = gene_sets.begin(); git != gene_sets.end(); git++) {
+        for (auto sit = (*git)->splits.begin(); sit != (*git)->splits.end(); sit++)
+            delete (*sit);
+        delete (*git)->taxa_mask;
+        delete (*git);
     }
     
     for (int i = 0; i < branches.size(); i++) {
@@ -640,6 +640,18 @@ void IQTree::computeInitialTree(LikelihoodKernel kernel, istream* in) {
             else
                 fixed_number = wrapperFixNegativeBranch(false);
             break;
+        case STT_SKETCH:
+            computeSketchTree(*params);
+            if (verbose_mode >= VB_MED) {
+                cout << "Computing initial tree took " << getRealTime() - start
+                << " wall-clock seconds" << endl;
+            }
+            params->numInitTrees = 1;
+            if (isSuperTree())
+                wrapperFixNegativeBranch(true);
+            else
+                fixed_number = wrapperFixNegativeBranch(false);
+            break;
         case STT_USER_TREE:
             ASSERT(0 && "User tree should be handled already");
             break;
@@ -3789,7 +3801,12 @@ void IQTree::writeUFBootTrees(Params &params) {
     int i, j;
     string filename = params.out_prefix;
     filename += ".ufboot";
-    ofstream out(filename.c_str());
+    ofstream out;
+    if (params.print_ufboot_bin) {
+        filename += ".bin";
+        out.open(filename.c_str(), ios::out | ios::binary);
+    } else
+        out.open(filename.c_str());
 
     trees.init(boot_trees, rooted);
     for (i = 0; i < trees.size(); i++) {
@@ -3802,6 +3819,8 @@ void IQTree::writeUFBootTrees(Params &params) {
             // reinsert removed seqs into each tree
             trees[i]->insertTaxa(removed_seqs, twin_seqs);
         }
+        if (params.print_ufboot_bin)
+            continue;
         // now print to file
         for (j = 0; j < trees.tree_weights[i]; j++)
             if (params.print_ufboot_trees == 1)
@@ -3809,6 +3828,11 @@ void IQTree::writeUFBootTrees(Params &params) {
             else
                 trees[i]->printTree(out, WT_NEWLINE + WT_BR_LEN);
     }
+    if (params.print_ufboot_bin) {
+        // as with NEWICK, tree i is stored tree_weights[i] times (sharing one record)
+        int brlen_bytes = (params.print_ufboot_trees == 1) ? 0 : params.print_ufboot_bin / 8;
+        trees.printBinaryTrees(out, brlen_bytes, true);
+    }
     cout << "UFBoot trees printed to " << filename << endl;
     out.close();
 }
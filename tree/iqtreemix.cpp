@@ -550,10 +550,7 @@ void IQTreeMix::initializeModel(Params &params, string model_name, ModelsBlock *
 // only one tree has been updated.
 double IQTreeMix::computeLikelihood_oneTreeUpdated(int whichTree) {
     double* pattern_lh_tree;
-    size_t i,j,ptn;
-    double logLike = 0.0;
-    double subLike;
-    double score;
+    size_t ptn;
     size_t t = whichTree;
     PhyloTree* ptree;
     
@@ -573,10 +570,11 @@ double IQTreeMix::computeLikelihood_oneTreeUpdated(int whichTree) {
     // cout << "[IQTreeMix::computeLikelihood] Tree " << t+1 << " : " << score << endl;
 
     // reorganize the array
-    j=t;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(num_threads > 1)
+#endif
     for (ptn=0; ptn<nptn; ptn++) {
-        ptn_like_cat[j] = exp(pattern_lh_tree[ptn]);
-        j+=ntree;
+        ptn_like_cat[ptn*ntree+t] = exp(pattern_lh_tree[ptn]);
     }
 
     // compute the overall likelihood value by combining all the existing likelihood values of the trees
@@ -585,37 +583,55 @@ double IQTreeMix::computeLikelihood_oneTreeUpdated(int whichTree) {
 
 double IQTreeMix::computeLikelihood(double *pattern_lh) {
     double* pattern_lh_tree;
-    size_t i,j,ptn,t;
-    double logLike = 0.0;
-    double subLike;
-    double score;
+    size_t ptn,t;
     PhyloTree* ptree;
     
+    // trees in parallel: the inner kernels run single-threaded as nested
+    // parallelism is off. The site rate's tree cannot be switched there, so each
+    // tree's rate must either already belong to it (unlinked rates) or not be
+    // site-specific, i.e. not computed from the patterns of its tree.
+    // Not for non-reversible models, which write to the (possibly shared)
+    // model when computing transition matrices
+    bool trees_in_parallel = (num_threads > 1 && ntree >= num_threads);
+    for (t=0; t<ntree && trees_in_parallel; t++)
+        trees_in_parallel = at(t)->getModel()->isReversible() &&
+            (at(t)->getRate()->getTree() == at(t) || !at(t)->getRate()->isSiteSpecificRate());
+
     // compute likelihood for each tree
-    pattern_lh_tree = _ptn_like_cat;
-    for (t=0; t<ntree; t++) {
-        // save the site rate's tree
-        ptree = at(t)->getRate()->getTree();
-        // set the tree t as the site rate's tree
-        // and compute the likelihood values
-        at(t)->getRate()->setTree(at(t));
-        at(t)->initializeAllPartialLh();
-        at(t)->clearAllPartialLH();
-        at(t)->computeLikelihood(pattern_lh_tree);
-        // set back the prevoius site rate's tree
-        at(t)->getRate()->setTree(ptree);
-        pattern_lh_tree += nptn;
+    if (trees_in_parallel) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (int k = 0; k < (int)ntree; k++) {
+            at(k)->initializeAllPartialLh();
+            at(k)->clearAllPartialLH();
+            at(k)->computeLikelihood(_ptn_like_cat + k*nptn);
+        }
+    } else {
+        pattern_lh_tree = _ptn_like_cat;
+        for (t=0; t<ntree; t++) {
+            // save the site rate's tree
+            ptree = at(t)->getRate()->getTree();
+            // set the tree t as the site rate's tree
+            // and compute the likelihood values
+            at(t)->getRate()->setTree(at(t));
+            at(t)->initializeAllPartialLh();
+            at(t)->clearAllPartialLH();
+            at(t)->computeLikelihood(pattern_lh_tree);
+            // set back the prevoius site rate's tree
+            at(t)->getRate()->setTree(ptree);
+            pattern_lh_tree += nptn;
+        }
     }
 
     // reorganize the array
-    i=0;
-    for (t=0; t<ntree; t++) {
-        j=t;
-        for (ptn=0; ptn<nptn; ptn++) {
-            ptn_like_cat[j] = exp(_ptn_like_cat[i]);
-            i++;
-            j+=ntree;
-        }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) private(t) if(num_threads > 1)
+#endif
+    for (ptn=0; ptn<nptn; ptn++) {
+        double *this_lk_cat = ptn_like_cat + ptn*ntree;
+        for (t=0; t<ntree; t++)
+            this_lk_cat[t] = exp(_ptn_like_cat[t*nptn+ptn]);
     }
     
     // compute the overall likelihood value by combining all the existing likelihood values of the trees
@@ -670,12 +686,14 @@ double IQTreeMix::computeLikelihood_combine(double *pattern_lh) {
     PhyloTree* ptree;
     
     // compute the total likelihood
-    i=0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) private(t, subLike, ptnLike) reduction(+:logLike) if(num_threads > 1)
+#endif
     for (ptn=0; ptn<nptn; ptn++) {
+        double *this_lk_cat = ptn_like_cat + ptn*ntree;
         subLike = 0.0;
         for (t=0; t<ntree; t++) {
-            subLike += ptn_like_cat[i] * weights[t];
-            i++;
+            subLike += this_lk_cat[t] * weights[t];
         }
         // cout << ptn << "\t" << log(subLike) << "\t" << patn_freqs[ptn] << endl;
         ptnLike = log(subLike);
@@ -1301,7 +1319,15 @@ uint64_t IQTreeMix::getMemoryRequiredThreaded(size_t ncategory, bool full_mem) {
     test the best number of threads
 */
 int IQTreeMix::testNumThreads() {
-    return at(0)->testNumThreads();
+    int best_threads = at(0)->testNumThreads();
+    setNumThreads(best_threads);
+    return best_threads;
+}
+
+void IQTreeMix::setNumThreads(int num_threads) {
+    PhyloTree::setNumThreads(num_threads);
+    for (iterator it = begin(); it != end(); it++)
+        (*it)->setNumThreads(num_threads);
 }
 
 /**
@@ -1998,24 +2024,22 @@ void IQTreeMix::getPostProb(double* pattern_mix_lh, bool need_computeLike, int u
     double lk_ptn;
 
     if (need_computeLike) {
-        computeLikelihood();
-    }
-
-    memcpy(pattern_mix_lh, ptn_like_cat, nptn*ntree*sizeof(double));
-
-    // multiply pattern_mix_lh by tree weights
-    i = 0;
-    for (ptn = 0; ptn < nptn; ptn++) {
-        for (c = 0; c < ntree; c++) {
-            pattern_mix_lh[i] *= weights[c];
-            i++;
-        }
+        if (update_which_tree >= 0)
+            computeLikelihood_oneTreeUpdated(update_which_tree);
+        else
+            computeLikelihood();
     }
 
+    // multiply the pattern likelihoods by tree weights and normalise them per pattern
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) private(c, this_lk_cat, lk_ptn) if(num_threads > 1)
+#endif
     for (ptn = 0; ptn < nptn; ptn++) {
         this_lk_cat = pattern_mix_lh + ptn*ntree;
+        double *ptn_lk_cat = ptn_like_cat + ptn*ntree;
         lk_ptn = 0.0;
         for (c = 0; c < ntree; c++) {
+            this_lk_cat[c] = ptn_lk_cat[c] * weights[c];
             lk_ptn += this_lk_cat[c];
         }
         ASSERT(lk_ptn != 0.0);
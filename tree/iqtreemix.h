@@ -162,6 +162,13 @@ public:
     */
     virtual int testNumThreads();
 
+    /**
+        set the number of threads for the mixture and all component trees.
+        With at least as many trees as threads, computeLikelihood() evaluates
+        the trees in parallel, otherwise one tree at a time over the patterns
+    */
+    virtual void setNumThreads(int num_threads);
+
     /**
         Initialize the tree weights using parsimony scores
         Idea:
@@ -370,6 +377,8 @@ private:
 
     /**
             get posterior probabilities along each site for each tree
+            @param update_which_tree if need_computeLike and >= 0, only this tree changed since
+                the last likelihood computation, so only its likelihoods are recomputed
      */
     void getPostProb(double* pattern_mix_lh, bool need_computeLike, int update_which_tree = -1);
     
@@ -441,26 +441,20 @@ void MTree::printTree(ostream &out, int brtype) {
     if (brtype & WT_NEWLINE) out << endl;
 }
 
-struct IntString {
-    int id;
-    string str;
-};
-
-/**
-	nodecmp, for pruning algorithm
-*/
-struct IntStringCmp
-{
-    /**
-    	nodecmp, for pruning algorithm
-    */
-    bool operator()(const IntString* s1, const IntString* s2) const
-    {
-        return (s1->id) < (s2->id);
+int MTree::computeSubtreeMinTaxonID(Node *node, Node *dad) {
+    int smallest_taxid = leafNum;
+    if (node->isLeaf())
+        smallest_taxid = node->id;
+    else {
+        FOR_NEIGHBOR_IT(node, dad, it)
+            if ((*it)->node->name != ROOT_NAME)
+                smallest_taxid = min(smallest_taxid, computeSubtreeMinTaxonID((*it)->node, node));
     }
-};
-
-typedef set<IntString*, IntStringCmp> IntStringSet;
+    if (node->id >= (int)subtree_min_taxid.size())
+        subtree_min_taxid.resize(node->id + 1, leafNum);
+    subtree_min_taxid[node->id] = smallest_taxid;
+    return smallest_taxid;
+}
 
 void MTree::printBranchLength(ostream &out, int brtype, bool print_slash, Neighbor *length_nei) {
     if (length_nei->length == -1.0)
@@ -544,29 +538,39 @@ int MTree::printTree(ostream &out, int brtype, Node *node, Node *dad)
                 length_nei = (*it);
             }
         } else {
-            IntStringSet strout;
+            // order subtrees by their smallest taxon ID and print them straight into out,
+            // rather than rendering every subtree into its own string first.
+            // The smallest IDs of all subtrees are computed once, by the outermost call
+            bool outermost = subtree_min_taxid.empty();
+            if (outermost)
+                computeSubtreeMinTaxonID(node, dad);
+            vector<pair<int, Neighbor*> > subtrees;
             FOR_NEIGHBOR_IT(node, dad, it) {
-                if ((*it)->node->name != ROOT_NAME) {
-                    ostringstream ss;
-                    IntString *str = new IntString;
-                    str->id = printTree(ss, brtype, (*it)->node, node);
-                    //ss.flush();
-                    str->str = ss.str();
-                    strout.insert(str);
-                } else
+                if ((*it)->node->name != ROOT_NAME)
+                    subtrees.push_back(make_pair(subtree_min_taxid[(*it)->node->id], *it));
+                else
                 	length_nei = (*it);
             } else {
             	length_nei = (*it);
             }
-            smallest_taxid = (*strout.begin())->id;
-            IntStringSet::iterator iss;
-            for (iss = strout.begin(); iss != strout.end(); iss++) {
+            stable_sort(subtrees.begin(), subtrees.end(),
+                [](const pair<int, Neighbor*> &a, const pair<int, Neighbor*> &b) { return a.first < b.first; });
+            smallest_taxid = subtrees.front().first;
+            // subtrees used to be printed into fresh ostringstreams, which start with
+            // default flags. A leaf sets ios::fixed, which must not carry over to the
+            // next subtree: the output has to stay byte-identical, as these strings
+            // are keys of the UFBoot and candidate tree sets and compared by equalTopology()
+            ios::fmtflags saved_flags = out.flags();
+            for (auto &subtree : subtrees) {
                 if (!first) out << ",";
-                out << (*iss)->str;
+                out.flags(ios::dec | ios::skipws);
+                printTree(out, brtype, subtree.second->node, node);
+                out.flags(saved_flags);
                 first = false;
             }
-            for (iss = strout.begin(); iss != strout.end(); iss++)
-                delete (*iss);
+            out.precision(num_precision);
+            if (outermost)
+                subtree_min_taxid.clear();
         }
         out << ")";
         if (brtype & WT_INT_NODE)
@@ -723,8 +727,13 @@ void MTree::readTreeString(string tree_string, bool is_rooted) {
 
 void MTree::readTree(istream &in, bool &is_rooted)
 {
-    in_line = 1;
-    in_column = 1;
+    readTree(in, is_rooted, 1, 1);
+}
+
+void MTree::readTree(istream &in, bool &is_rooted, int start_line, int start_column)
+{
+    in_line = start_line;
+    in_column = start_column;
     in_comment = "";
     try {
         char ch;
@@ -817,6 +826,28 @@ void MTree::initializeTree(Node *node, Node* dad)
     }
 }
 
+/**
+    read one character from a NEWICK stream, behaving like istream::get(ch)
+    but pulling straight from the stream buffer, which saves the sentry that get()
+    builds for every single character of large tree files
+    @param in input stream
+    @param ch (OUT) the character read
+    @return false and set eofbit/failbit (like get) if nothing could be read
+ */
+static inline bool getNewickChar(istream &in, char &ch) {
+    if (!in.good()) {
+        in.setstate(ios::failbit);
+        return false;
+    }
+    int c = in.rdbuf()->sbumpc();
+    if (c == char_traits<char>::eof()) {
+        in.setstate(ios::eofbit | ios::failbit);
+        return false;
+    }
+    ch = (char)c;
+    return true;
+}
+
 void MTree::parseBranchLength(string &lenstr, DoubleVector &branch_len) {
 //    branch_len.push_back(convert_double(lenstr.c_str()));
     string KEYWORD="&";
@@ -938,7 +969,8 @@ void MTree::parseFile(istream &infile, char &ch, Node* &root, DoubleVector &bran
         seqname += ch;
         seqlen++;
 //        seqname[seqlen++] = ch;
-        ch = infile.get();
+        if (!getNewickChar(infile, ch))
+            ch = (char)EOF;
         in_column++;
         if (end_ch != 0 && ch == end_ch) {
             seqname += ch;
@@ -981,7 +1013,8 @@ void MTree::parseFile(istream &infile, char &ch, Node* &root, DoubleVector &bran
 //            seqname[seqlen] = ch;
             seqname += ch;
             seqlen++;
-            ch = infile.get();
+            if (!getNewickChar(infile, ch))
+                ch = (char)EOF;
             in_column++;
         }
         if ((controlchar(ch) || ch == '[') && !infile.eof())
@@ -1889,11 +1922,11 @@ int MTree::freeNode(Node *node, Node *dad)
 }
 
 char MTree::readNextChar(istream &in, char current_ch) {
-    char ch;
+    char ch = 0;
     if (current_ch == '[')
         ch = current_ch;
     else {
-        in.get(ch);
+        getNewickChar(in, ch);
         in_column++;
         if (ch == 10) {
             in_line++;
@@ -1901,18 +1934,18 @@ char MTree::readNextChar(istream &in, char current_ch) {
         }
     }
     while (controlchar(ch) && !in.eof()) {
-        in.get(ch);
+        getNewickChar(in, ch);
         in_column++;
         if (ch == 10) {
             in_line++;
             in_column = 1;
         }
     }
-    in_comment = "";
+    in_comment.clear();
     // ignore comment
     while (ch=='[' && !in.eof()) {
         while (ch!=']' && !in.eof()) {
-            in.get(ch);
+            getNewickChar(in, ch);
             if (ch != ']')
                 in_comment += ch;
             in_column++;
@@ -1923,14 +1956,14 @@ char MTree::readNextChar(istream &in, char current_ch) {
         }
         if (ch != ']') throw "Comments not ended with ]";
         in_column++;
-        in.get(ch);
+        getNewickChar(in, ch);
         if (ch == 10) {
             in_line++;
             in_column = 1;
         }
         while (controlchar(ch) && !in.eof()) {
             in_column++;
-            in.get(ch);
+            getNewickChar(in, ch);
             if (ch == 10) {
                 in_line++;
                 in_column = 1;
@@ -311,6 +311,17 @@ public:
      */
     virtual void readTree(istream &in, bool &is_rooted);
 
+    /**
+            read the tree from the ifstream in newick format, where the tree
+            starts at the given line and column of the input file
+            (so that errors are reported relative to that file)
+            @param in the input stream.
+            @param is_rooted (IN/OUT) true if tree is rooted
+            @param start_line line of the input file where the tree starts
+            @param start_column column of the input file where the tree starts
+     */
+    void readTree(istream &in, bool &is_rooted, int start_line, int start_column);
+
     /**
             read the tree from a newick string
             @param tree_string the tree string.
@@ -995,6 +1006,20 @@ protected:
      */
     string fig_char;
 
+    /**
+            smallest taxon ID in the subtree below each node (indexed by node ID),
+            set up by printTree() while it prints with WT_SORT_TAXA, empty otherwise
+     */
+    IntVector subtree_min_taxid;
+
+    /**
+            fill subtree_min_taxid for the subtree below node (away from dad), bottom-up
+            @param node the starting node
+            @param dad dad of the node, used to direct the search
+            @return the smallest taxon ID in the subtree, i.e. the value printTree() returns for it
+     */
+    int computeSubtreeMinTaxonID(Node *node, Node *dad);
+
     /**
             check tree is bifurcating tree (every leaf with level 1 or 3)
             @param node the starting node, NULL to start from the root
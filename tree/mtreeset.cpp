@@ -20,6 +20,7 @@
 #include "mtreeset.h"
 #include "alignment/alignment.h"
 #include "utils/gzstream.h"
+#include <exception>
 
 MTreeSet::MTreeSet()
 {
@@ -165,10 +166,566 @@ void MTreeSet::init(vector<string> &trees, vector<string> &taxonNames, bool &is_
 
 }
 
+/*********************************************
+	binary tree files
+*********************************************/
+
+/** magic string at the beginning of a binary tree file */
+static const char TREE_BIN_MAGIC[8] = {'I', 'Q', 'T', 'R', 'E', 'E', 'B', '1'};
+
+/** byte order marker, written after the index and branch length sizes, in the byte order
+	of the machine that wrote the file (which is read as 0x0201 with the other byte order) */
+static const uint16_t TREE_BIN_BYTE_ORDER = 0x0102;
+
+/**
+	@return true if infile starts with the magic string of a binary tree file
+*/
+static bool isBinaryTreeFile(const char *infile, bool compressed) {
+	char magic[sizeof(TREE_BIN_MAGIC)];
+	istream *in;
+	if (compressed) in = new igzstream(infile); else in = new ifstream(infile, ios::binary);
+	bool is_binary = in->read(magic, sizeof(magic)) && memcmp(magic, TREE_BIN_MAGIC, sizeof(magic)) == 0;
+	delete in;
+	return is_binary;
+}
+
+template <class T>
+static void writeBinary(string &buf, T value) {
+	buf.append((const char*)&value, sizeof(T));
+}
+
+static void writeBinaryIndex(string &buf, int value, int index_bytes) {
+	if (index_bytes == 2)
+		writeBinary<uint16_t>(buf, value);
+	else
+		writeBinary<uint32_t>(buf, value);
+}
+
+static void writeBinaryString(string &buf, const string &str) {
+	writeBinary<uint32_t>(buf, str.length());
+	buf += str;
+}
+
+/**
+	read a value from a binary buffer
+	@param pos (IN/OUT) current position, moved past the value
+	@param end end of the buffer
+*/
+template <class T>
+static T readBinary(const char *&pos, const char *end) {
+	if (end - pos < (ptrdiff_t)sizeof(T))
+		throw "Binary tree file is truncated";
+	T value;
+	memcpy(&value, pos, sizeof(T));
+	pos += sizeof(T);
+	return value;
+}
+
+static int readBinaryIndex(const char *&pos, const char *end, int index_bytes) {
+	if (index_bytes == 2)
+		return readBinary<uint16_t>(pos, end);
+	return readBinary<uint32_t>(pos, end);
+}
+
+static string readBinaryString(const char *&pos, const char *end) {
+	uint32_t len = readBinary<uint32_t>(pos, end);
+	if (end - pos < (ptrdiff_t)len)
+		throw "Binary tree file is truncated";
+	string str(pos, len);
+	pos += len;
+	return str;
+}
+
+/**
+	a tree flattened in preorder from its root, as stored in a binary tree file
+*/
+struct FlatTree {
+	bool rooted;
+	/** index of the parent of each node, -1 for the root */
+	IntVector parent;
+	/** length of the branch from each node to its parent */
+	DoubleVector length;
+	/** taxon index of each leaf, in preorder */
+	IntVector taxon;
+	/** names of internal nodes (e.g. support values) */
+	vector<pair<int, string> > labels;
+};
+
+static void flattenTree(Node *node, Node *dad, int dad_index, double length, FlatTree &flat,
+	StringIntMap &taxon_index, StrVector &taxon_names)
+{
+	int index = flat.parent.size();
+	flat.parent.push_back(dad_index);
+	flat.length.push_back(length);
+	if (node->isLeaf()) {
+		auto it = taxon_index.find(node->name);
+		if (it == taxon_index.end()) {
+			flat.taxon.push_back(taxon_names.size());
+			taxon_index[node->name] = taxon_names.size();
+			taxon_names.push_back(node->name);
+		} else
+			flat.taxon.push_back(it->second);
+	} else if (!node->name.empty())
+		flat.labels.push_back(make_pair(index, node->name));
+	FOR_NEIGHBOR_IT(node, dad, it)
+		flattenTree((*it)->node, node, index, (*it)->length, flat, taxon_index, taxon_names);
+}
+
+/**
+	rebuild a tree from its record in a binary tree file
+	@param pos start of the tree record
+	@param end end of the buffer
+	@param tree (OUT) an empty tree
+*/
+static void unflattenTree(const char *pos, const char *end, MTree *tree, const StrVector &taxon_names,
+	int index_bytes, int brlen_bytes)
+{
+	bool rooted = readBinary<uint8_t>(pos, end);
+	int num_nodes = readBinary<uint32_t>(pos, end);
+	int num_leaves = readBinary<uint32_t>(pos, end);
+	int num_labels = readBinary<uint32_t>(pos, end);
+	if (num_nodes < 2 || num_leaves < 2 || num_leaves > num_nodes)
+		throw "Invalid tree in binary tree file";
+
+	IntVector parent(num_nodes, -1), num_children(num_nodes, 0);
+	for (int i = 1; i < num_nodes; i++) {
+		parent[i] = readBinaryIndex(pos, end, index_bytes);
+		if (parent[i] < 0 || parent[i] >= i)
+			throw "Invalid tree in binary tree file";
+		num_children[parent[i]]++;
+	}
+
+	vector<Node*> nodes(num_nodes);
+	Node *root_leaf = NULL;
+	int leaf_id = 0, leaf = 0;
+	for (int i = 0; i < num_nodes; i++) {
+		if (num_children[i] == 0 || (i == 0 && num_children[i] == 1)) {
+			if (leaf++ == num_leaves)
+				throw "Invalid tree in binary tree file";
+			int taxon = readBinaryIndex(pos, end, index_bytes);
+			if (taxon < 0 || (size_t)taxon >= taxon_names.size())
+				throw "Invalid taxon in binary tree file";
+			nodes[i] = tree->newNode(-1, taxon_names[taxon].c_str());
+			// as in NEWICK reading, the root of a rooted tree gets the last leaf ID
+			if (taxon_names[taxon] == ROOT_NAME)
+				root_leaf = nodes[i];
+			else
+				nodes[i]->id = leaf_id++;
+		} else
+			nodes[i] = tree->newNode();
+	}
+	if (leaf != num_leaves)
+		throw "Invalid tree in binary tree file";
+	if (root_leaf)
+		root_leaf->id = leaf_id;
+
+	for (int i = 1; i < num_nodes; i++) {
+		double len = -1.0;
+		if (brlen_bytes == 4)
+			len = readBinary<float>(pos, end);
+		else if (brlen_bytes == 8)
+			len = readBinary<double>(pos, end);
+		nodes[parent[i]]->addNeighbor(nodes[i], len);
+		nodes[i]->addNeighbor(nodes[parent[i]], len);
+	}
+	for (int i = 0; i < num_labels; i++) {
+		int node = readBinary<uint32_t>(pos, end);
+		if (node < 0 || node >= num_nodes)
+			throw "Invalid tree in binary tree file";
+		nodes[node]->name = readBinaryString(pos, end);
+	}
+
+	tree->root = nodes[0];
+	tree->leafNum = num_leaves;
+	tree->rooted = rooted;
+	tree->initializeTree();
+}
+
+void MTreeSet::printBinaryTrees(const char *ofile, int brlen_bytes, bool expand_weights) {
+	try {
+		ofstream out;
+		out.exceptions(ios::failbit | ios::badbit);
+		out.open(ofile, ios::out | ios::binary);
+		printBinaryTrees(out, brlen_bytes, expand_weights);
+		out.close();
+		cout << "Tree(s) were printed to " << ofile << endl;
+	} catch (const ios::failure&) {
+		outError(ERR_WRITE_OUTPUT, ofile);
+	}
+}
+
+void MTreeSet::printBinaryTrees(ostream &out, int brlen_bytes, bool expand_weights) {
+	ASSERT(brlen_bytes == 0 || brlen_bytes == 4 || brlen_bytes == 8);
+	StringIntMap taxon_index;
+	StrVector taxon_names;
+	vector<FlatTree> flats(size());
+	int max_index = 0;
+	for (size_t i = 0; i < size(); i++) {
+		MTree *tree = at(i);
+		flats[i].rooted = tree->rooted;
+		flattenTree(tree->root, NULL, -1, 0.0, flats[i], taxon_index, taxon_names);
+		max_index = max(max_index, (int)flats[i].parent.size());
+	}
+	max_index = max(max_index, (int)taxon_names.size());
+	int index_bytes = (max_index <= UINT16_MAX) ? 2 : 4;
+
+	// the tree records, and where each of them starts
+	string records;
+	vector<uint64_t> offsets(size());
+	for (size_t i = 0; i < size(); i++) {
+		FlatTree &flat = flats[i];
+		int num_nodes = flat.parent.size();
+		offsets[i] = records.length();
+		writeBinary<uint8_t>(records, flat.rooted);
+		writeBinary<uint32_t>(records, num_nodes);
+		writeBinary<uint32_t>(records, flat.taxon.size());
+		writeBinary<uint32_t>(records, flat.labels.size());
+		for (int j = 1; j < num_nodes; j++)
+			writeBinaryIndex(records, flat.parent[j], index_bytes);
+		for (int taxon : flat.taxon)
+			writeBinaryIndex(records, taxon, index_bytes);
+		for (int j = 1; j < num_nodes; j++)
+			if (brlen_bytes == 4)
+				writeBinary<float>(records, flat.length[j]);
+			else if (brlen_bytes == 8)
+				writeBinary<double>(records, flat.length[j]);
+		for (auto &label : flat.labels) {
+			writeBinary<uint32_t>(records, label.first);
+			writeBinaryString(records, label.second);
+		}
+	}
+
+	string header(TREE_BIN_MAGIC, sizeof(TREE_BIN_MAGIC));
+	writeBinary<uint8_t>(header, index_bytes);
+	writeBinary<uint8_t>(header, brlen_bytes);
+	writeBinary<uint16_t>(header, TREE_BIN_BYTE_ORDER);
+	writeBinary<uint32_t>(header, taxon_names.size());
+	for (auto &name : taxon_names)
+		writeBinaryString(header, name);
+	vector<uint64_t> index;
+	for (size_t i = 0; i < size(); i++) {
+		int copies = (expand_weights && i < tree_weights.size()) ? tree_weights[i] : 1;
+		index.insert(index.end(), copies, offsets[i]);
+	}
+	writeBinary<uint64_t>(header, index.size());
+	for (uint64_t offset : index)
+		writeBinary<uint64_t>(header, offset);
+
+	out.write(header.data(), header.length());
+	out.write(records.data(), records.length());
+}
+
+/** maximal number of bytes of tree records read from a binary tree file before they are decoded */
+static const uint64_t TREE_BIN_BATCH_BYTES = 1 << 24;
+
+/**
+	read a value from a binary stream
+*/
+template <class T>
+static T readBinary(istream &in) {
+	T value;
+	if (!in.read((char*)&value, sizeof(T)))
+		throw "Binary tree file is truncated";
+	return value;
+}
+
+static string readBinaryString(istream &in) {
+	uint32_t len = readBinary<uint32_t>(in);
+	string str(len, 0);
+	if (len > 0 && !in.read(&str[0], len))
+		throw "Binary tree file is truncated";
+	return str;
+}
+
+/** an open binary tree file, see MTreeSet::printBinaryTrees() */
+struct BinaryTreeFile {
+	istream *in = NULL;
+	bool compressed = false;
+	StrVector taxon_names;
+	/** offset of each tree record, relative to the first record */
+	vector<uint64_t> index;
+	int index_bytes = 0;
+	int brlen_bytes = 0;
+	/** position of the first record in the file */
+	streamoff records_start = 0;
+	/** offset of the next record byte to be read, relative to the first record */
+	uint64_t read_pos = 0;
+	~BinaryTreeFile() { delete in; }
+};
+
+/**
+	open a binary tree file and read its header (taxa and index of tree records);
+	the records themselves are read later, as they are needed
+*/
+static void openBinaryTreeFile(const char *infile, bool compressed, BinaryTreeFile &file) {
+	try {
+		file.compressed = compressed;
+		if (compressed) file.in = new igzstream; else file.in = new ifstream;
+		file.in->exceptions(ios::badbit);
+		if (compressed) ((igzstream*)file.in)->open(infile); else ((ifstream*)file.in)->open(infile, ios::in | ios::binary);
+		istream &in = *file.in;
+		in.ignore(sizeof(TREE_BIN_MAGIC));
+		file.index_bytes = readBinary<uint8_t>(in);
+		file.brlen_bytes = readBinary<uint8_t>(in);
+		uint16_t byte_order = readBinary<uint16_t>(in);
+		if (byte_order != TREE_BIN_BYTE_ORDER) {
+			if (byte_order == (uint16_t)((TREE_BIN_BYTE_ORDER >> 8) | (TREE_BIN_BYTE_ORDER << 8)))
+				throw "Binary tree file was written on a machine with a different byte order";
+			throw "Unsupported binary tree file format";
+		}
+		if ((file.index_bytes != 2 && file.index_bytes != 4) ||
+			(file.brlen_bytes != 0 && file.brlen_bytes != 4 && file.brlen_bytes != 8))
+			throw "Unsupported binary tree file format";
+		int num_taxa = readBinary<uint32_t>(in);
+		for (int i = 0; i < num_taxa; i++)
+			file.taxon_names.push_back(readBinaryString(in));
+		uint64_t num_trees = readBinary<uint64_t>(in);
+		for (uint64_t i = 0; i < num_trees; i++)
+			file.index.push_back(readBinary<uint64_t>(in));
+		// tree records follow the index
+		if (!compressed)
+			file.records_start = in.tellg();
+	} catch (const char *str) {
+		outError((string)str + ": " + infile);
+	} catch (const ios::failure&) {
+		outError(ERR_READ_INPUT, infile);
+	}
+}
+
+/**
+	read one tree record; records must be read in increasing order of offset
+	@param offset offset of the record, relative to the first record
+	@param length length of the record, UINT64_MAX if it runs to the end of the file
+*/
+static void readBinaryRecord(BinaryTreeFile &file, uint64_t offset, uint64_t length, string &record) {
+	istream &in = *file.in;
+	if (offset > file.read_pos) {
+		// gzip streams cannot seek, so they skip forward by reading
+		if (file.compressed)
+			in.ignore(offset - file.read_pos);
+		else
+			in.seekg(file.records_start + (streamoff)offset);
+	}
+	record.clear();
+	if (length == UINT64_MAX) {
+		char chunk[1 << 16];
+		while (in.read(chunk, sizeof(chunk)) || in.gcount() > 0)
+			record.append(chunk, in.gcount());
+	} else {
+		record.resize(length);
+		if (length > 0 && !in.read(&record[0], length))
+			throw "Binary tree file is truncated";
+	}
+	file.read_pos = offset + record.length();
+}
+
+/**
+	decode the tree records at the given offsets into trees[start], trees[start+1], ...
+	The records are read in file order, a batch at a time, and each batch is decoded in parallel.
+*/
+static void unflattenTrees(BinaryTreeFile &file, const vector<uint64_t> &offsets,
+	MTreeSet &trees, size_t start, const char *infile) {
+	// a record ends where the next one in the file starts
+	vector<uint64_t> bounds(file.index);
+	sort(bounds.begin(), bounds.end());
+	bounds.erase(unique(bounds.begin(), bounds.end()), bounds.end());
+	vector<size_t> order(offsets.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return offsets[a] < offsets[b]; });
+
+	vector<string> records;
+	vector<size_t> record_of;
+	for (size_t next = 0; next < order.size(); ) {
+		size_t batch_start = next;
+		uint64_t batch_bytes = 0;
+		records.clear();
+		record_of.clear();
+		try {
+			for (; next < order.size() && batch_bytes < TREE_BIN_BATCH_BYTES; next++) {
+				uint64_t offset = offsets[order[next]];
+				// trees stored several times share one record
+				if (next == batch_start || offset != offsets[order[next-1]]) {
+					vector<uint64_t>::iterator it = upper_bound(bounds.begin(), bounds.end(), offset);
+					uint64_t length = (it == bounds.end()) ? UINT64_MAX : *it - offset;
+					records.push_back(string());
+					readBinaryRecord(file, offset, length, records.back());
+					batch_bytes += records.back().length();
+				}
+				record_of.push_back(records.size()-1);
+			}
+		} catch (const char *str) {
+			outError((string)str + ": " + infile);
+		} catch (const ios::failure&) {
+			outError(ERR_READ_INPUT, infile);
+		}
+
+		// trees are independent records, so they can be decoded in parallel; an
+		// exception must not leave the parallel region, so the first one is kept
+		exception_ptr error;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+		for (size_t i = batch_start; i < next; i++) {
+			try {
+				const string &record = records[record_of[i-batch_start]];
+				unflattenTree(record.data(), record.data() + record.length(), trees.at(start+order[i]),
+					file.taxon_names, file.index_bytes, file.brlen_bytes);
+			} catch (...) {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+				if (!error)
+					error = current_exception();
+			}
+		}
+		if (error) {
+			try {
+				rethrow_exception(error);
+			} catch (const char *str) {
+				outError((string)str + ": " + infile);
+			}
+		}
+	}
+}
+
+void MTreeSet::readBinaryTrees(const char *infile, int burnin, int max_count,
+	IntVector *weights, bool compressed)
+{
+	BinaryTreeFile file;
+	openBinaryTreeFile(infile, compressed, file);
+	size_t num_trees = file.index.size();
+
+	if (burnin > 0) {
+		size_t discarded = min((size_t)burnin, num_trees);
+		cout << discarded << " beginning tree(s) discarded" << endl;
+		if (discarded == num_trees)
+			outError("Burnin value is too large.");
+	}
+	size_t start = size();
+	int omitted = 0;
+	vector<uint64_t> offsets;
+	for (int count = 1; (size_t)(burnin + count - 1) < num_trees && count <= max_count; count++) {
+		if (weights && !weights->at(count-1)) {
+			omitted++;
+			continue;
+		}
+		offsets.push_back(file.index[burnin + count - 1]);
+		push_back(newTree());
+		tree_weights.push_back(weights ? weights->at(count-1) : 1);
+	}
+	unflattenTrees(file, offsets, *this, start, infile);
+
+	cout << size() << " tree(s) loaded (" << countRooted() << " rooted and " << countUnrooted() << " unrooted)" << endl;
+	if (omitted) cout << omitted << " tree(s) omitted" << endl;
+}
+
+void MTreeSet::readBinaryTrees(const char *infile, const IntVector &tree_ids, bool compressed)
+{
+	BinaryTreeFile file;
+	openBinaryTreeFile(infile, compressed, file);
+	size_t start = size();
+	vector<uint64_t> offsets;
+	for (int id : tree_ids) {
+		if (id < 0 || (size_t)id >= file.index.size())
+			outError("Tree " + convertIntToString(id) + " is not in binary tree file " + infile);
+		offsets.push_back(file.index[id]);
+		push_back(newTree());
+		tree_weights.push_back(1);
+	}
+	unflattenTrees(file, offsets, *this, start, infile);
+}
+
+/** line and column of the next character to be read from a tree file */
+struct TreeFilePosition {
+	int line = 1;
+	int column = 1;
+	void advance(int c) {
+		if (c == '\n') {
+			line++;
+			column = 1;
+		} else
+			column++;
+	}
+};
+
+/** skip white space, keeping track of the position */
+static void skipNewickSpace(streambuf *buf, TreeFilePosition &pos) {
+	for (int c = buf->sgetc(); c != char_traits<char>::eof() && isspace(c); c = buf->sgetc()) {
+		buf->sbumpc();
+		pos.advance(c);
+	}
+}
+
+/**
+	read the text of one NEWICK tree (up to and including the ';' outside comments),
+	and the white space that follows it
+	@param in input stream
+	@param tree_str (OUT) the tree text
+	@param pos (IN/OUT) position in the file
+	@param tree_start (OUT) position of the first character of the tree
+*/
+static void readNewickString(istream &in, string &tree_str, TreeFilePosition &pos,
+	pair<int,int> &tree_start) {
+	tree_str.clear();
+	streambuf *buf = in.rdbuf();
+	skipNewickSpace(buf, pos);
+	tree_start = make_pair(pos.line, pos.column);
+	int comment_level = 0;
+	for (int c = buf->sbumpc(); c != char_traits<char>::eof(); c = buf->sbumpc()) {
+		tree_str += (char)c;
+		pos.advance(c);
+		if (c == '[')
+			comment_level++;
+		else if (c == ']' && comment_level > 0)
+			comment_level--;
+		else if (c == ';' && comment_level == 0) {
+			skipNewickSpace(buf, pos);
+			return;
+		}
+	}
+	// unterminated tree: leave it for readTree() to report
+	in.setstate(ios::eofbit);
+}
+
+void MTreeSet::parseTreeStrings(StrVector &tree_strs, vector<pair<int,int> > &tree_starts,
+	bool is_rooted) {
+	int start = size();
+	int num_trees = tree_strs.size();
+	for (int i = 0; i < num_trees; i++)
+		push_back(newTree());
+	// the first exception is rethrown after the parallel region
+	exception_ptr error;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int i = 0; i < num_trees; i++) {
+		try {
+			stringstream ss(tree_strs[i]);
+			bool myrooted = is_rooted;
+			at(start+i)->readTree(ss, myrooted, tree_starts[i].first, tree_starts[i].second);
+		} catch (...) {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+			if (!error)
+				error = current_exception();
+		}
+	}
+	tree_strs.clear();
+	tree_starts.clear();
+	if (error)
+		rethrow_exception(error);
+}
+
 void MTreeSet::readTrees(const char *infile, bool &is_rooted, int burnin, int max_count,
 	IntVector *weights, bool compressed) 
 {
 	cout << "Reading tree(s) file " << infile << " ..." << endl;
+	if (isBinaryTreeFile(infile, compressed)) {
+		readBinaryTrees(infile, burnin, max_count, weights, compressed);
+		return;
+	}
 	int count, omitted;
 /*	IntVector ok_trees;
 	if (trees_id) {
@@ -184,25 +741,45 @@ void MTreeSet::readTrees(const char *infile, bool &is_rooted, int burnin, int ma
 		in->exceptions(ios::failbit | ios::badbit);
 		
 		if (compressed) ((igzstream*)in)->open(infile); else ((ifstream*)in)->open(infile);
+		TreeFilePosition pos;
 		if (burnin > 0) {
 			int cnt = 0;
 			while (cnt < burnin && !in->eof()) {
 				char ch;
-				(*in) >> ch;
+				in->get(ch);
+				pos.advance(ch);
 				if (ch == ';') cnt++;
 			}
 			cout << cnt << " beginning tree(s) discarded" << endl;
 			if (in->eof())
 				throw "Burnin value is too large.";
 		}
+		// with several threads, the tree texts are collected in batches and parsed concurrently
+		// (not with random branch lengths, which must be drawn in file order)
+		bool parse_parallel = Params::getInstance().num_threads > 1 && !Params::getInstance().branch_distribution;
+		const size_t MAX_BATCH_CHARS = 1 << 26;
+		StrVector tree_strs;
+		vector<pair<int,int> > tree_starts;
+		size_t batch_chars = 0;
 		for (count = 1, omitted = 0; !in->eof() && count <= max_count; count++) {
 			if (!weights || weights->at(count-1)) {
 				//cout << "Reading tree " << count << " ..." << endl;
-				MTree *tree = newTree();
-				bool myrooted = is_rooted;
-				//tree->userFile = (char*) infile;
-				tree->readTree(*in, myrooted);
-				push_back(tree);
+				if (parse_parallel) {
+					tree_strs.emplace_back();
+					tree_starts.emplace_back();
+					readNewickString(*in, tree_strs.back(), pos, tree_starts.back());
+					batch_chars += tree_strs.back().length();
+					if (batch_chars >= MAX_BATCH_CHARS) {
+						parseTreeStrings(tree_strs, tree_starts, is_rooted);
+						batch_chars = 0;
+					}
+				} else {
+					MTree *tree = newTree();
+					bool myrooted = is_rooted;
+					//tree->userFile = (char*) infile;
+					tree->readTree(*in, myrooted);
+					push_back(tree);
+				}
 				if (weights) 
 					tree_weights.push_back(weights->at(count-1)); 
 				else tree_weights.push_back(1);
@@ -214,9 +791,11 @@ void MTreeSet::readTrees(const char *infile, bool &is_rooted, int burnin, int ma
 				//in->exceptions(ios::badbit);
 				while (!in->eof()) {
 					char ch;
-					if (!((*in) >> ch)) break;
+					if (!in->get(ch)) break;
+					pos.advance(ch);
 					if (ch == ';') break;
 				}
+				skipNewickSpace(in->rdbuf(), pos);
 				omitted++;
 			} 
 			char ch;
@@ -227,6 +806,8 @@ void MTreeSet::readTrees(const char *infile, bool &is_rooted, int burnin, int ma
 			in->exceptions(ios::failbit | ios::badbit);
 
 		}
+		if (!tree_strs.empty())
+			parseTreeStrings(tree_strs, tree_starts, is_rooted);
 		cout << size() << " tree(s) loaded (" << countRooted() << " rooted and " << countUnrooted() << " unrooted)" << endl;
 		if (omitted) cout << omitted << " tree(s) omitted" << endl;
 		//in->exceptions(ios::failbit | ios::badbit);
@@ -331,7 +912,7 @@ void MTreeSet::printTrees(const char *ofile, int  brtype)
 		printTrees(out, brtype);
 		out.close();
 		cout << "Tree(s) were printed to " << ofile << endl;
-	} catch (ios::failure) {
+	} catch (const ios::failure&) {
 		outError(ERR_WRITE_OUTPUT, ofile);
 	}
 }
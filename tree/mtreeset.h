@@ -80,6 +80,35 @@ public:
 	void readTrees(const char *userTreeFile, bool &is_rooted, int burnin, int max_count,
 		IntVector *weights = NULL, bool compressed = false);
 
+	/**
+		parse NEWICK strings into trees appended to this set, in parallel when multiple threads are used
+		@param tree_strs NEWICK strings of one tree each, cleared on return
+		@param tree_starts line and column of the input file where each string starts
+		       (for error messages), cleared on return
+		@param is_rooted true if tree is rooted
+	*/
+	void parseTreeStrings(StrVector &tree_strs, vector<pair<int,int> > &tree_starts, bool is_rooted);
+
+	/**
+		read the trees from a binary tree file written by printBinaryTrees()
+		@param infile the input file name
+		@param burnin the number of beginning trees to be discarded
+		@param max_count max number of trees to load
+		@param weights if not NULL, trees with zero weight are omitted
+		@param compressed true if the file is gzipped
+	*/
+	void readBinaryTrees(const char *infile, int burnin, int max_count,
+		IntVector *weights = NULL, bool compressed = false);
+
+	/**
+		read some trees from a binary tree file written by printBinaryTrees(), using the
+		index of the file to decode only those trees
+		@param infile the input file name
+		@param tree_ids the numbers (0-based, in file order) of the trees to read
+		@param compressed true if the file is gzipped
+	*/
+	void readBinaryTrees(const char *infile, const IntVector &tree_ids, bool compressed = false);
+
 	/**
 		assign the leaf IDs with their names for all trees
 
@@ -121,6 +150,23 @@ public:
 	*/
 	void printTrees(ostream & out, int brtype = WT_BR_LEN);
 
+	/**
+		print the trees to a binary tree file: a taxon table, an index of tree offsets for
+		random access, then each tree as a preorder parent-index array with branch lengths
+		@param outfile the output file.
+		@param brlen_bytes 4 or 8 to store branch lengths as float or double, 0 to omit them
+		@param expand_weights true to store tree i tree_weights[i] times (sharing one record)
+	*/
+	void printBinaryTrees(const char *outfile, int brlen_bytes, bool expand_weights = false);
+
+	/**
+		print the trees to a binary tree file, see above
+		@param out the output stream, opened in binary mode
+		@param brlen_bytes 4 or 8 to store branch lengths as float or double, 0 to omit them
+		@param expand_weights true to store tree i tree_weights[i] times (sharing one record)
+	*/
+	void printBinaryTrees(ostream &out, int brlen_bytes, bool expand_weights = false);
+
 	/**
 		convert all trees into the split system
 		@param taxname certain taxa name
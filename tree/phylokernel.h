@@ -1695,7 +1695,7 @@ void PhyloTree::computePartialParsimonyFastSIMD(PhyloNeighbor *dad_branch, Phylo
         switch (nstates) {
         case 4:
             #ifdef _OPENMP
-            #pragma omp parallel for private (site) reduction(+: score) if(nsites>num_threads*10)
+            #pragma omp parallel for private (site) reduction(+: score) if(nsites>max(num_threads,1)*10)
             #endif
             for (site = 0; site<nsites; site++) {
                 size_t offset = entry_size*site;
@@ -1718,7 +1718,7 @@ void PhyloTree::computePartialParsimonyFastSIMD(PhyloNeighbor *dad_branch, Phylo
                 
         default:
             #ifdef _OPENMP
-            #pragma omp parallel for private (site) reduction(+: score) if(nsites>num_threads*10)
+            #pragma omp parallel for private (site) reduction(+: score) if(nsites>max(num_threads,1)*10)
             #endif
             for (site = 0; site<nsites; site++) {
                 size_t offset = entry_size*site;
@@ -1767,47 +1767,55 @@ int PhyloTree::computeParsimonyBranchFastSIMD(PhyloNeighbor *dad_branch, PhyloNo
     int scoreid = nsites*entry_size;
     UINT sum_end_node = (dad_branch->partial_pars[scoreid] + node_branch->partial_pars[scoreid]);
     UINT score = sum_end_node;
-    UINT lower_bound = best_pars_score;
-    if (branch_subst) lower_bound = INT_MAX;
-    
-    switch (nstates) {
-    case 4:
+    UINT lower_bound = pars_score_bound;
+    if (branch_subst) lower_bound = UINT_MAX;
+
+    // score PARS_BOUND_CHUNK site blocks at a time (in parallel), adding each
+    // chunk to the shared score; chunks not yet started are skipped once the
+    // score reaches lower_bound (the candidate can no longer win)
+    bool in_parallel = nsites > max(num_threads,1)*10;
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) if(in_parallel)
+    #endif
+    for (int start = 0; start < nsites; start += PARS_BOUND_CHUNK) {
+        UINT cur_score;
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+: score) if(nsites>num_threads*10)
+        #pragma omp atomic read
         #endif
-        for (int site = 0; site < nsites; site++) {
-            size_t offset = entry_size*site;
-            VectorClass *x = (VectorClass*)(dad_branch->partial_pars + offset);
-            VectorClass *y = (VectorClass*)(node_branch->partial_pars + offset);
-            VectorClass w = (x[0] & y[0]) | (x[1] & y[1]) | (x[2] & y[2]) | (x[3] & y[3]);
-            w = ~w;
-            score += fast_popcount(w);
-            #ifndef _OPENMP
-            if (score >= lower_bound) 
-                break;
-            #endif
+        cur_score = score;
+        if (cur_score >= lower_bound)
+            continue;
+        int stop = min(start + PARS_BOUND_CHUNK, nsites);
+        UINT chunk_score = 0;
+        switch (nstates) {
+        case 4:
+            for (int site = start; site < stop; site++) {
+                size_t offset = entry_size*site;
+                VectorClass *x = (VectorClass*)(dad_branch->partial_pars + offset);
+                VectorClass *y = (VectorClass*)(node_branch->partial_pars + offset);
+                VectorClass w = (x[0] & y[0]) | (x[1] & y[1]) | (x[2] & y[2]) | (x[3] & y[3]);
+                w = ~w;
+                chunk_score += fast_popcount(w);
+            }
+            break;
+        default:
+            for (int site = start; site < stop; ++site) {
+                size_t offset = entry_size*site;
+                VectorClass *x = (VectorClass*)(dad_branch->partial_pars + offset);
+                VectorClass *y = (VectorClass*)(node_branch->partial_pars + offset);
+                VectorClass w = x[0] & y[0];
+                for (int i = 1; i < nstates; i++) {
+                    w |= x[i] & y[i];
+                }
+                w = ~w;
+                chunk_score += fast_popcount(w);
+            }
+            break;
         }
-        break;
-    default:
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+: score) if(nsites>num_threads*10)
+        #pragma omp atomic
         #endif
-        for (int site = 0; site < nsites; ++site) {
-            size_t offset = entry_size*site;
-            VectorClass *x = (VectorClass*)(dad_branch->partial_pars + offset);
-            VectorClass *y = (VectorClass*)(node_branch->partial_pars + offset);
-            VectorClass w = x[0] & y[0];
-            for (int i = 1; i < nstates; i++) {
-                w |= x[i] & y[i];
-            }
-            w = ~w;
-            score += fast_popcount(w);
-            #ifndef _OPENMP
-            if (score >= lower_bound) 
-                break;
-            #endif
-        }
-        break;
+        score += chunk_score;
     }
     if (branch_subst) {
         *branch_subst = score - sum_end_node;
@@ -1819,6 +1827,48 @@ int PhyloTree::computeParsimonyBranchFastSIMD(PhyloNeighbor *dad_branch, PhyloNo
  Sankoff parsimony function
  ****************************************************************************/
 
+/**
+ min-plus product of the cost matrix and a child's Sankoff vectors:
+ out[i] += min_j (child[j] + cost_matrix[i*nstates+j]), for VectorClass::size()
+ patterns at a time. Rows are done four at a time, so that each child entry
+ is loaded once per four target states (which matters for 20 or 61 states).
+ @param out nstates vectors to add the result to
+ @param child nstates vectors of the child branch
+ @param cost_matrix nstates*nstates cost matrix (row = target state)
+ */
+template<class VectorClass>
+inline void sankoffMinPlusAdd(VectorClass *out, const VectorClass *child, const UINT *cost_matrix, int nstates) {
+    int i = 0;
+    for (; i+4 <= nstates; i += 4) {
+        const UINT *cost0 = cost_matrix + i*nstates;
+        const UINT *cost1 = cost0 + nstates;
+        const UINT *cost2 = cost1 + nstates;
+        const UINT *cost3 = cost2 + nstates;
+        VectorClass min0 = child[0] + cost0[0];
+        VectorClass min1 = child[0] + cost1[0];
+        VectorClass min2 = child[0] + cost2[0];
+        VectorClass min3 = child[0] + cost3[0];
+        for (int j = 1; j < nstates; j++) {
+            VectorClass value = child[j];
+            min0 = min(value + cost0[j], min0);
+            min1 = min(value + cost1[j], min1);
+            min2 = min(value + cost2[j], min2);
+            min3 = min(value + cost3[j], min3);
+        }
+        out[i] += min0;
+        out[i+1] += min1;
+        out[i+2] += min2;
+        out[i+3] += min3;
+    }
+    for (; i < nstates; i++) {
+        const UINT *cost = cost_matrix + i*nstates;
+        VectorClass min0 = child[0] + cost[0];
+        for (int j = 1; j < nstates; j++)
+            min0 = min(child[j] + cost[j], min0);
+        out[i] += min0;
+    }
+}
+
 template<class VectorClass>
 void PhyloTree::computePartialParsimonySankoffSIMD(PhyloNeighbor *dad_branch, PhyloNode *dad){
     // don't recompute the parsimony
@@ -1886,19 +1936,9 @@ void PhyloTree::computePartialParsimonySankoffSIMD(PhyloNeighbor *dad_branch, Ph
                         partial_pars_ptr[i] += tip_buffer[i];
                     }
                 } else {
-                    // internal node
+                    // internal node: min(j->i) from child_branch
                     VectorClass *partial_pars_child_ptr = (VectorClass*)&((PhyloNeighbor*) (*it))->partial_pars[ptn_start_index];
-                    UINT *cost_matrix_ptr = cost_matrix;
-                    
-                    for (int i = 0; i < nstates; i++){
-                        // min(j->i) from child_branch
-                        VectorClass min_child_ptn_pars = partial_pars_child_ptr[0] + cost_matrix_ptr[0];
-                        for (int j = 1; j < nstates; j++) {
-                            min_child_ptn_pars = min(partial_pars_child_ptr[j] + cost_matrix_ptr[j], min_child_ptn_pars);
-                        }
-                        partial_pars_ptr[i] += min_child_ptn_pars;
-                        cost_matrix_ptr += nstates;
-                    }
+                    sankoffMinPlusAdd(partial_pars_ptr, partial_pars_child_ptr, cost_matrix, nstates);
                 }
             }
         }
@@ -1949,18 +1989,11 @@ void PhyloTree::computePartialParsimonySankoffSIMD(PhyloNeighbor *dad_branch, Ph
             
             VectorClass *right_ptr = (VectorClass*)&right->partial_pars[ptn_start_index];
             VectorClass *partial_pars_ptr = (VectorClass*)&partial_pars[ptn_start_index];
-            UINT *cost_matrix_ptr = cost_matrix;
-            VectorClass right_contrib;
             
-            for(int i = 0; i < nstates; i++){
-                // min(j->i) from child_branch
-                right_contrib = right_ptr[0] + cost_matrix_ptr[0];
-                for(int j = 1; j < nstates; j++) {
-                    right_contrib = min(right_ptr[j] + cost_matrix_ptr[j], right_contrib);
-                }
-                partial_pars_ptr[i] = tip_buffer[i] + right_contrib;
-                cost_matrix_ptr += nstates;
-            }
+            for (int i = 0; i < nstates; i++)
+                partial_pars_ptr[i] = tip_buffer[i];
+            // min(j->i) from child_branch
+            sankoffMinPlusAdd(partial_pars_ptr, right_ptr, cost_matrix, nstates);
         }
     } else {
         // inner-inner case
@@ -1972,20 +2005,10 @@ void PhyloTree::computePartialParsimonySankoffSIMD(PhyloNeighbor *dad_branch, Ph
             VectorClass *left_ptr = (VectorClass*)&left->partial_pars[ptn_start_index];
             VectorClass *right_ptr = (VectorClass*)&right->partial_pars[ptn_start_index];
             VectorClass *partial_pars_ptr = (VectorClass*)&partial_pars[ptn_start_index];
-            UINT *cost_matrix_ptr = cost_matrix;
-            VectorClass left_contrib, right_contrib;
             
-            for (int i = 0; i < nstates; i++){
-                // min(j->i) from child_branch
-                left_contrib = left_ptr[0] + cost_matrix_ptr[0];
-                right_contrib = right_ptr[0] + cost_matrix_ptr[0];
-                for (int j = 1; j < nstates; j++) {
-                    left_contrib = min(left_ptr[j] + cost_matrix_ptr[j], left_contrib);
-                    right_contrib = min(right_ptr[j] + cost_matrix_ptr[j], right_contrib);
-                }
-                partial_pars_ptr[i] = left_contrib+right_contrib;
-                cost_matrix_ptr += nstates;
-            }
+            // min(j->i) from each child_branch (partial_pars was zeroed above)
+            sankoffMinPlusAdd(partial_pars_ptr, left_ptr, cost_matrix, nstates);
+            sankoffMinPlusAdd(partial_pars_ptr, right_ptr, cost_matrix, nstates);
         }
         
     }
@@ -2030,11 +2053,21 @@ int PhyloTree::computeParsimonyBranchSankoffSIMD(PhyloNeighbor *dad_branch, Phyl
     VectorClass tree_pars = 0;
     int nstates = aln->num_states;
     VectorClass branch_pars = 0;
+    size_t nptn = aln->ordered_pattern.size();
+
+    // every chunk of patterns, stop if the score has reached the bound
+    // (the candidate being scored can no longer win)
+    UINT lower_bound = pars_score_bound;
+    if (branch_subst) lower_bound = UINT_MAX;
+    size_t chunk = PARS_BOUND_CHUNK * VectorClass::size();
     
     if (dad->isLeaf()) {
         VectorClass *tip_buffer = aligned_alloc<VectorClass>(nstates);
         // external node
-        for (size_t ptn = 0; ptn < aln->ordered_pattern.size(); ptn+=VectorClass::size()){
+        for (size_t ptn = 0; ptn < nptn; ptn+=VectorClass::size()){
+            if (ptn % chunk == 0 && ptn > 0 && lower_bound != UINT_MAX
+                && (UINT)horizontal_add(tree_pars) >= lower_bound)
+                break;
             int ptn_start_index = ptn * nstates;
             for (int  i = 0; i < VectorClass::size(); i++) {
                 UINT *node_branch_ptr = &tip_partial_pars[aln->ordered_pattern[ptn+i][dad->id]*nstates];
@@ -2057,9 +2090,29 @@ int PhyloTree::computeParsimonyBranchSankoffSIMD(PhyloNeighbor *dad_branch, Phyl
             branch_pars += br_ptn_pars * VectorClass().load_a(&ptn_freq_pars[ptn]);
         }
         aligned_free(tip_buffer);
-    }  else {
+    } else if (!branch_subst) {
+        // internal node, score only
+        VectorClass *min_buffer = aligned_alloc<VectorClass>(nstates);
+        for (size_t ptn = 0; ptn < nptn; ptn+=VectorClass::size()){
+            if (ptn % chunk == 0 && ptn > 0 && lower_bound != UINT_MAX
+                && (UINT)horizontal_add(tree_pars) >= lower_bound)
+                break;
+            int ptn_start_index = ptn * nstates;
+            VectorClass *node_branch_ptr = (VectorClass*)&node_branch->partial_pars[ptn_start_index];
+            VectorClass *dad_branch_ptr = (VectorClass*)&dad_branch->partial_pars[ptn_start_index];
+            for (int i = 0; i < nstates; i++)
+                min_buffer[i] = dad_branch_ptr[i];
+            // min(j->i) from node_branch, plus dad_branch
+            sankoffMinPlusAdd(min_buffer, node_branch_ptr, cost_matrix, nstates);
+            VectorClass min_ptn_pars = min_buffer[0];
+            for (int i = 1; i < nstates; i++)
+                min_ptn_pars = min(min_buffer[i], min_ptn_pars);
+            tree_pars += min_ptn_pars * VectorClass().load_a(&ptn_freq_pars[ptn]);
+        }
+        aligned_free(min_buffer);
+    } else {
         // internal node
-        for (size_t ptn = 0; ptn < aln->ordered_pattern.size(); ptn+=VectorClass::size()){
+        for (size_t ptn = 0; ptn < nptn; ptn+=VectorClass::size()){
             int ptn_start_index = ptn * nstates;
             VectorClass *node_branch_ptr = (VectorClass*)&node_branch->partial_pars[ptn_start_index];
             VectorClass *dad_branch_ptr = (VectorClass*)&dad_branch->partial_pars[ptn_start_index];
@@ -19,43 +19,43 @@ void PhyloNeighbor::clearForwardPartialLh(Node *dad) {
 			((PhyloNeighbor*)*it)->clearForwardPartialLh(node);
 }
 
-void PhyloNode::clearReversePartialLh(PhyloNode *dad) {
-//	PhyloNeighbor *node_nei = (PhyloNeighbor*)findNeighbor(dad);
-//	assert(node_nei);
-//	node_nei->partial_lh_computed = 0;
+void PhyloNode::clearPartialLhTowardDad(PhyloNode *dad) {
 	for (NeighborVec::iterator it = neighbors.begin(); it != neighbors.end(); it ++)
-		if ((*it)->node != dad) {
-            PhyloNeighbor *nei = (PhyloNeighbor*)(*it)->node->findNeighbor(this);
+		if ((*it)->node == dad) {
+			PhyloNeighbor *nei = (PhyloNeighbor*)*it;
 			nei->partial_lh_computed = 0;
-            nei->size = 0;
-			((PhyloNode*)(*it)->node)->clearReversePartialLh(this);
-		}
+			nei->size = 0;
+		} else
+			((PhyloNode*)(*it)->node)->clearPartialLhTowardDad(this);
 }
 
-void PhyloNode::clearAllPartialLh(bool make_null, PhyloNode* dad) {
-	PhyloNeighbor* node_nei = (PhyloNeighbor*)findNeighbor(dad);
-	node_nei->partial_lh_computed = 0;
-	if (make_null) node_nei->partial_lh = NULL;
-
-
-	if (Params::getInstance().lh_mem_save == LM_MEM_SAVE)
-		node_nei->size = 0;
+void PhyloNode::clearReversePartialLh(PhyloNode *dad) {
+	for (NeighborVec::iterator it = neighbors.begin(); it != neighbors.end(); it ++)
+		if ((*it)->node != dad)
+			((PhyloNode*)(*it)->node)->clearPartialLhTowardDad(this);
+}
 
-	node_nei = (PhyloNeighbor*)dad->findNeighbor(this);
-	node_nei->partial_lh_computed = 0;
-	if (make_null) {
-		node_nei->partial_lh = NULL;
-	}
-	if (Params::getInstance().lh_mem_save == LM_MEM_SAVE) {
-		node_nei->size = 0;
-	}
+void PhyloNode::clearOutgoingPartialLh(bool make_null, PhyloNode *dad, bool mem_save) {
 	for (NeighborVec::iterator it = neighbors.begin(); it != neighbors.end(); it++) {
-		if ((*it)->node != dad) {
-			((PhyloNode*)(*it)->node)->clearAllPartialLh(make_null, this);
-		}
+		PhyloNeighbor *nei = (PhyloNeighbor*)*it;
+		nei->partial_lh_computed = 0;
+		if (make_null) nei->partial_lh = NULL;
+		if (mem_save) nei->size = 0;
+		if (nei->node != dad)
+			((PhyloNode*)nei->node)->clearOutgoingPartialLh(make_null, this, mem_save);
 	}
 }
 
+void PhyloNode::clearAllPartialLh(bool make_null, PhyloNode* dad) {
+	bool mem_save = (Params::getInstance().lh_mem_save == LM_MEM_SAVE);
+	// branch from dad to this node, every other branch is cleared from the node it leaves
+	PhyloNeighbor* node_nei = (PhyloNeighbor*)dad->findNeighbor(this);
+	node_nei->partial_lh_computed = 0;
+	if (make_null) node_nei->partial_lh = NULL;
+	if (mem_save) node_nei->size = 0;
+	clearOutgoingPartialLh(make_null, dad, mem_save);
+}
+
 
 PhyloNode::PhyloNode()
  : Node()
@@ -252,6 +252,20 @@ public:
     */
     int computeSize(Node *dad);
 
+protected:
+
+    /**
+        tell that the partial likelihood vectors of all branches leaving this node are not computed,
+        recursively for the subtree away from dad
+     */
+    void clearOutgoingPartialLh(bool make_null, PhyloNode *dad, bool mem_save);
+
+    /**
+        tell that the partial likelihood vector from this node towards dad is not computed,
+        recursively for the subtree away from dad
+     */
+    void clearPartialLhTowardDad(PhyloNode *dad);
+
 };
 
 
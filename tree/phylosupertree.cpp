@@ -29,11 +29,15 @@ PhyloSuperTree::PhyloSuperTree()
 {
 	totalNNIs = evalNNIs = 0;
     rescale_codon_brlen = false;
+    num_big_parts = 0;
+    part_num_threads = 1;
 	// Initialize the counter for evaluated NNIs on subtrees. FOR THIS CASE IT WON'T BE initialized.
 }
 
 PhyloSuperTree::PhyloSuperTree(SuperAlignment *alignment, bool new_iqtree) :  IQTree(alignment) {
     totalNNIs = evalNNIs = 0;
+    num_big_parts = 0;
+    part_num_threads = 1;
 
     rescale_codon_brlen = false;
     bool has_codon = false;
@@ -71,6 +75,8 @@ PhyloSuperTree::PhyloSuperTree(SuperAlignment *alignment, bool new_iqtree) :  IQ
 
 PhyloSuperTree::PhyloSuperTree(SuperAlignment *alignment, PhyloSuperTree *super_tree) :  IQTree(alignment) {
 	totalNNIs = evalNNIs = 0;
+    num_big_parts = 0;
+    part_num_threads = 1;
     rescale_codon_brlen = super_tree->rescale_codon_brlen;
 	part_info = super_tree->part_info;
 	for (vector<Alignment*>::iterator it = alignment->partitions.begin(); it != alignment->partitions.end(); it++) {
@@ -93,6 +99,11 @@ void PhyloSuperTree::setModelFactory(ModelFactory *model_fac) {
         for (int part = 0; part != size(); part++) {
             at(part)->setModelFactory(tree->at(part)->getModelFactory());
         }
+        // partition costs depend on the number of categories of the models
+        if (computePartitionOrder()) {
+            deleteAllPartialLh();
+            initializeAllPartialLh();
+        }
     } else {
         for (int part = 0; part != size(); part++) {
             at(part)->setModelFactory(NULL);
@@ -225,9 +236,16 @@ void PhyloSuperTree::changeLikelihoodKernel(LikelihoodKernel lk) {
 }
 
 void PhyloSuperTree::setNumThreads(int num_threads) {
-    PhyloTree::setNumThreads((size() >= num_threads) ? num_threads : 1);
-    for (iterator it = begin(); it != end(); it++)
-        (*it)->setNumThreads((size() >= num_threads) ? 1 : num_threads);
+    part_num_threads = num_threads;
+    if (empty()) {
+        PhyloTree::setNumThreads(num_threads);
+        return;
+    }
+    // assign threads to partitions by their computation costs
+    if (computePartitionOrder()) {
+        deleteAllPartialLh();
+        initializeAllPartialLh();
+    }
 }
 
 void PhyloSuperTree::printResultTree(string suffix) {
@@ -651,37 +669,75 @@ int PhyloSuperTree::computeParsimonyBranchObsolete(PhyloNeighbor *dad_branch, Ph
     return score;
 }
 
-void PhyloSuperTree::computePartitionOrder() {
-    if (!part_order.empty())
-        return;
+/**
+    @return number of rate (and mixture) categories the likelihood kernels of a partition loop over,
+    1 if the partition model is not yet initialized
+*/
+static int getPartitionNumCat(PhyloTree *tree) {
+    if (!tree->getModelFactory() || !tree->getModel() || !tree->getRate())
+        return 1;
+    return max(tree->getNumLhCat(WSL_MIXTURE_RATECAT), 1);
+}
+
+bool PhyloSuperTree::computePartitionOrder() {
     int i, ntrees = size();
+    IntVector part_ncat(ntrees);
     part_order.resize(ntrees);
     part_order_by_nptn.resize(ntrees);
+    for (i = 0; i < ntrees; i++)
+        part_ncat[i] = getPartitionNumCat(at(i));
+    num_big_parts = 0;
 #ifdef _OPENMP
     int *id = new int[ntrees];
     double *cost = new double[ntrees];
+    double total_cost = 0.0;
     
     for (i = 0; i < ntrees; i++) {
         Alignment *part_aln = at(i)->aln;
-        cost[i] = -((double)part_aln->getNSeq())*part_aln->getNPattern()*part_aln->num_states;
+        cost[i] = -((double)part_aln->getNSeq())*part_aln->getNPattern()*part_aln->num_states*part_ncat[i];
+        total_cost -= cost[i];
         id[i] = i;
     }
     quicksort(cost, 0, ntrees-1, id);
     for (i = 0; i < ntrees; i++) 
         part_order[i] = id[i];
-        
-    // compute part_order by number of patterns
+
+    // a partition costing more than the average load per thread cannot be balanced by
+    // distributing whole partitions (longest first): give it all threads over its patterns
+    if (part_num_threads > 1)
+        while (num_big_parts < ntrees && -cost[num_big_parts] > total_cost / part_num_threads)
+            num_big_parts++;
+    
+    // compute part_order by number of patterns, big partitions first
     for (i = 0; i < ntrees; i++) {
         Alignment *part_aln = at(i)->aln;
-        cost[i] = -((double)part_aln->getNPattern())*part_aln->num_states;
+        cost[i] = -((double)part_aln->getNPattern())*part_aln->num_states*part_ncat[i];
         id[i] = i;
     }
+    total_cost = 0.0;
+    for (i = 0; i < ntrees; i++)
+        total_cost -= cost[i];
+    for (i = 0; i < num_big_parts; i++)
+        cost[part_order[i]] -= total_cost;
     quicksort(cost, 0, ntrees-1, id);
     for (i = 0; i < ntrees; i++) 
         part_order_by_nptn[i] = id[i];
         
     delete [] cost;
     delete [] id;
+
+    // buffer_partial_lh is sized by the number of threads (see getBufferPartialLhSize()),
+    // so it has to be re-allocated if a partition gets a different number
+    bool realloc_needed = false;
+    for (i = 0; i < ntrees; i++) {
+        PhyloTree *part_tree = at(part_order[i]);
+        int part_threads = (i < num_big_parts) ?
+            min(part_num_threads, max((int)(part_tree->aln->getNPattern()/8), 1)) : 1;
+        if (part_tree->num_threads != part_threads && part_tree->buffer_partial_lh)
+            realloc_needed = true;
+        part_tree->setNumThreads(part_threads);
+    }
+    PhyloTree::setNumThreads((ntrees - num_big_parts > 1) ? part_num_threads : 1);
     
     if (verbose_mode >= VB_MED) {
         cout << "Partitions ordered by computation costs:" << endl;
@@ -689,12 +745,17 @@ void PhyloSuperTree::computePartitionOrder() {
         for (i = 0; i < ntrees; i++)
             cout << "  charset " << at(part_order[i])->aln->name << " = " << at(part_order[i])->aln->position_spec << ";" << endl;
         cout << "end;" << endl;
+        if (num_big_parts > 0)
+            cout << "First " << num_big_parts << " partition(s) computed one at a time with "
+                 << "pattern-parallel kernels, the others in parallel" << endl;
     }
+    return realloc_needed;
 #else
     for (i = 0; i < ntrees; i++) {
         part_order[i] = i;
         part_order_by_nptn[i] = i;
     }
+    return false;
 #endif // OPENMP
 }
 
@@ -711,15 +772,10 @@ double PhyloSuperTree::computeLikelihood(double *pattern_lh) {
 			pattern_lh += at(i)->getAlnNPattern();
 		}
 	} else {
-        if (part_order.empty()) computePartitionOrder();
-		#ifdef _OPENMP
-		#pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) if(num_threads > 1)
-		#endif
-		for (int j = 0; j < ntrees; j++) {
-            int i = part_order[j];
-			part_info[i].cur_score = at(i)->computeLikelihood();
-			tree_lh += part_info[i].cur_score;
-		}
+        tree_lh = sumOverPartitions([&](int i) -> double {
+            part_info[i].cur_score = at(i)->computeLikelihood();
+            return part_info[i].cur_score;
+        });
 	}
 	return tree_lh;
 }
@@ -772,17 +828,12 @@ void PhyloSuperTree::computePatternProbabilityCategory(double *ptn_prob_cat, Sit
 double PhyloSuperTree::optimizeAllBranches(int my_iterations, double tolerance, int maxNRStep) {
 	double tree_lh = 0.0;
 	int ntrees = size();
-    if (part_order.empty()) computePartitionOrder();
-	#ifdef _OPENMP
-	#pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) if(num_threads > 1)
-	#endif
-	for (int j = 0; j < ntrees; j++) {
-        int i = part_order[j];
-		part_info[i].cur_score = at(i)->optimizeAllBranches(my_iterations, tolerance/min(ntrees,10), maxNRStep);
-		tree_lh += part_info[i].cur_score;
-		if (verbose_mode >= VB_MAX)
-			at(i)->printTree(cout, WT_BR_LEN + WT_NEWLINE);
-	}
+    tree_lh = sumOverPartitions([&](int i) -> double {
+        part_info[i].cur_score = at(i)->optimizeAllBranches(my_iterations, tolerance/min(ntrees,10), maxNRStep);
+        if (verbose_mode >= VB_MAX)
+            at(i)->printTree(cout, WT_BR_LEN + WT_NEWLINE);
+        return part_info[i].cur_score;
+    });
 
 	if (my_iterations >= 100) computeBranchLengths();
 	return tree_lh;
@@ -907,17 +958,15 @@ NNIMove PhyloSuperTree::getBestNNIForBran(PhyloNode *node1, PhyloNode *node2, NN
 	//double bestScore = optimizeOneBranch(node1, node2, false);
 
 	int ntrees = size(), part;
-	double nni_score1 = 0.0, nni_score2 = 0.0;
-	int local_totalNNIs = 0, local_evalNNIs = 0;
-
-    if (part_order.empty()) computePartitionOrder();
-	#ifdef _OPENMP
-	#pragma omp parallel for reduction(+: nni_score1, nni_score2, local_totalNNIs, local_evalNNIs) private(part) schedule(dynamic) if(num_threads>1)
-	#endif
-	for (int treeid = 0; treeid < ntrees; treeid++) {
-        part = part_order_by_nptn[treeid];
+	// scores of the two NNIs summed over partitions, and numbers of NNIs
+	struct NNIScores {
+		double score1, score2;
+		int total, eval;
+	};
+	NNIScores no_scores = {0.0, 0.0, 0, 0};
+	NNIScores scores = reduceOverPartitions(no_scores, [&](int part) -> NNIScores {
+		NNIScores res = {0.0, 0.0, 1, 0};
 		bool is_nni = true;
-		local_totalNNIs++;
 		FOR_NEIGHBOR_DECLARE(node1, NULL, nit) {
 			if (! ((SuperNeighbor*)*nit)->link_neighbors[part]) { is_nni = false; break; }
 		}
@@ -930,12 +979,11 @@ NNIMove PhyloSuperTree::getBestNNIForBran(PhyloNode *node1, PhyloNode *node2, NN
 				if (save_all_trees == 2 || nniMoves)
 					at(part)->computePatternLikelihood(part_info[part].cur_ptnlh, &part_info[part].cur_score);
 			}
-			nni_score1 += part_info[part].cur_score;
-			nni_score2 += part_info[part].cur_score;
-			continue;
+			res.score1 = res.score2 = part_info[part].cur_score;
+			return res;
 		}
 
-		local_evalNNIs++;
+		res.eval = 1;
 		part_info[part].evalNNIs++;
 
 		PhyloNeighbor *nei1_part = nei1->link_neighbors[part];
@@ -969,19 +1017,22 @@ NNIMove PhyloSuperTree::getBestNNIForBran(PhyloNode *node1, PhyloNode *node2, NN
 			part_info[part].nniMoves[0] = part_info[part].nniMoves[1];
 			part_info[part].nniMoves[1] = tmp;
 		}
-		nni_score1 += part_info[part].nniMoves[0].newloglh;
-		nni_score2 += part_info[part].nniMoves[1].newloglh;
+		res.score1 = part_info[part].nniMoves[0].newloglh;
+		res.score2 = part_info[part].nniMoves[1].newloglh;
 		int numlen = 1;
 		if (params->nni5) numlen = 5;
 		for (int i = 0; i < numlen; i++) {
 			part_info[part].nni1_brlen[brid*numlen + i] = part_info[part].nniMoves[0].newLen[i];
 			part_info[part].nni2_brlen[brid*numlen + i] = part_info[part].nniMoves[1].newLen[i];
 		}
-
-	}
-	totalNNIs += local_totalNNIs;
-	evalNNIs += local_evalNNIs;
-	double nni_scores[2] = {nni_score1, nni_score2};
+		return res;
+	}, [](const NNIScores &a, const NNIScores &b) -> NNIScores {
+		NNIScores sum = {a.score1 + b.score1, a.score2 + b.score2, a.total + b.total, a.eval + b.eval};
+		return sum;
+	}, true);
+	totalNNIs += scores.total;
+	evalNNIs += scores.eval;
+	double nni_scores[2] = {scores.score1, scores.score2};
     
     if (!nni_ok[0]) nni_scores[0] = -DBL_MAX;
     if (!nni_ok[1]) nni_scores[1] = -DBL_MAX;
@@ -1420,15 +1471,10 @@ void PhyloSuperTree::writeMarginalAncestralState(ostream &out, PhyloNode *node,
     for (auto it = begin(); it != end(); ++it, ++part) {
         size_t nsites  = (*it)->getAlnNSite();
         int    nstates = (*it)->model->num_states;
+        StrVector ptn_str;
+        (*it)->formatMarginalAncestralPatterns(out, ptn_ancestral_prob, ptn_ancestral_seq, ptn_str);
         for (size_t site = 0; site < nsites; ++site) {
-            int ptn = (*it)->aln->getPatternID(site);
-            out << node->name << "\t" << part << "\t" << site+1 << "\t";
-            out << (*it)->aln->convertStateBackStr(ptn_ancestral_seq[ptn]);
-            double *state_prob = ptn_ancestral_prob + ptn*nstates;
-            for (int j = 0; j < nstates; ++j) {
-                out << "\t" << state_prob[j];
-            }
-            out << endl;
+            out << node->name << "\t" << part << "\t" << site+1 << "\t" << ptn_str[(*it)->aln->getPatternID(site)];
         }
         size_t nptn = (*it)->getAlnNPattern();
         ptn_ancestral_prob += nptn*nstates;
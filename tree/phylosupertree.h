@@ -20,6 +20,7 @@
 #ifndef PHYLOSUPERTREE_H
 #define PHYLOSUPERTREE_H
 
+#include <functional>
 #include "iqtree.h"
 #include "supernode.h"
 #include "alignment/superalignment.h"
@@ -362,8 +363,76 @@ public:
     IntVector part_order;
     IntVector part_order_by_nptn;
 
-    /* compute part_order vector */
-    void computePartitionOrder();
+    /**
+        number of leading partitions in part_order (and part_order_by_nptn) that are too
+        costly to balance across threads; they are computed one at a time with
+        pattern-parallel kernels, the remaining ones in parallel with one thread each
+    */
+    int num_big_parts;
+
+    /* number of threads shared by all partitions */
+    int part_num_threads;
+
+    /**
+        compute part_order vector and assign threads to partitions;
+        called by setNumThreads() and again once the models are set up (setModelFactory())
+        @return true if a partition with allocated buffers got a different number of threads,
+        so that the partial likelihood buffers have to be re-allocated
+    */
+    bool computePartitionOrder();
+
+    /**
+        evaluate part_func(part) for all partitions and combine the results with reduce:
+        the big partitions (see num_big_parts) one at a time, then the others
+        in parallel, largest first, with a dynamic schedule
+        @param identity initial value of the result (and of each thread's partial result)
+        @param part_func function of a partition ID
+        @param reduce function combining two results
+        @param by_nptn true to go through part_order_by_nptn rather than part_order
+        @return combined result
+    */
+    template <class T, class PartFunc, class ReduceFunc>
+    T reduceOverPartitions(T identity, PartFunc part_func, ReduceFunc reduce, bool by_nptn = false) {
+        if (part_order.empty())
+            computePartitionOrder();
+        const IntVector &order = by_nptn ? part_order_by_nptn : part_order;
+        int ntrees = size();
+        T result = identity;
+        for (int j = 0; j < num_big_parts; j++)
+            result = reduce(result, part_func(order[j]));
+#ifdef _OPENMP
+#pragma omp parallel if(num_threads > 1)
+        {
+            T thread_result = identity;
+#pragma omp for schedule(dynamic) nowait
+            for (int j = num_big_parts; j < ntrees; j++)
+                thread_result = reduce(thread_result, part_func(order[j]));
+#pragma omp critical (reduce_over_partitions)
+            result = reduce(result, thread_result);
+        }
+#else
+        for (int j = num_big_parts; j < ntrees; j++)
+            result = reduce(result, part_func(order[j]));
+#endif
+        return result;
+    }
+
+    /**
+        sum of part_func(part) over all partitions, scheduled as in reduceOverPartitions()
+    */
+    template <class PartFunc>
+    double sumOverPartitions(PartFunc part_func, bool by_nptn = false) {
+        return reduceOverPartitions(0.0, part_func, std::plus<double>(), by_nptn);
+    }
+
+    /**
+        call part_func(part) for all partitions, scheduled as in reduceOverPartitions()
+    */
+    template <class PartFunc>
+    void forEachPartition(PartFunc part_func, bool by_nptn = false) {
+        reduceOverPartitions(0, [&](int part) -> int { part_func(part); return 0; },
+                             [](int, int) -> int { return 0; }, by_nptn);
+    }
 
     /**
             get the name of the model
@@ -277,17 +277,12 @@ void PhyloSuperTreePlen::optimizeOneBranch(PhyloNode *node1, PhyloNode *node2, b
 	//this->clearAllPartialLH();
 	PhyloTree::optimizeOneBranch(node1, node2, false, maxNRStep);
 
-    if (part_order.empty()) computePartitionOrder();
 	// bug fix: assign cur_score into part_info
-    #ifdef _OPENMP
-    #pragma omp parallel for private(part) schedule(dynamic) if(num_threads > 1)
-    #endif    
-    for (int partid = 0; partid < size(); partid++) {
-        part = part_order_by_nptn[partid];
+    forEachPartition([&](int part) {
         if (((SuperNeighbor*)current_it)->link_neighbors[part]) {
             part_info[part].cur_score = at(part)->computeLikelihoodFromBuffer();
         }
-    }
+    }, true);
 
 	if(clearLH && current_len != current_it->length){
 		for (int part = 0; part < size(); part++) {
@@ -306,7 +301,6 @@ void PhyloSuperTreePlen::optimizeOneBranch(PhyloNode *node1, PhyloNode *node2, b
 double PhyloSuperTreePlen::computeFunction(double value) {
 
 	double tree_lh = 0.0;
-	int ntrees = size();
 
 	if (!central_partial_lh) initializeAllPartialLh();
 
@@ -318,27 +312,21 @@ double PhyloSuperTreePlen::computeFunction(double value) {
 	SuperNeighbor *nei2 = (SuperNeighbor*)current_it->node->findNeighbor(current_it_back->node);
 	ASSERT(nei1 && nei2);
 
-    if (part_order.empty()) computePartitionOrder();
-    #ifdef _OPENMP
-    #pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) if(num_threads > 1)
-    #endif    
-	for (int partid = 0; partid < ntrees; partid++) {
-            int part = part_order_by_nptn[partid];
-			PhyloNeighbor *nei1_part = nei1->link_neighbors[part];
-			PhyloNeighbor *nei2_part = nei2->link_neighbors[part];
-			if (nei1_part && nei2_part) {
-				at(part)->current_it = nei1_part;
-				at(part)->current_it_back = nei2_part;
-				nei1_part->length += lambda*part_info[part].part_rate;
-				nei2_part->length += lambda*part_info[part].part_rate;
-				part_info[part].cur_score = at(part)->computeLikelihoodBranch(nei2_part,(PhyloNode*)nei1_part->node);
-				tree_lh += part_info[part].cur_score;
-			} else {
-				if (part_info[part].cur_score == 0.0)
-					part_info[part].cur_score = at(part)->computeLikelihood();
-				tree_lh += part_info[part].cur_score;
-			}
-		}
+    tree_lh = sumOverPartitions([&](int part) -> double {
+        PhyloNeighbor *nei1_part = nei1->link_neighbors[part];
+        PhyloNeighbor *nei2_part = nei2->link_neighbors[part];
+        if (nei1_part && nei2_part) {
+            at(part)->current_it = nei1_part;
+            at(part)->current_it_back = nei2_part;
+            nei1_part->length += lambda*part_info[part].part_rate;
+            nei2_part->length += lambda*part_info[part].part_rate;
+            part_info[part].cur_score = at(part)->computeLikelihoodBranch(nei2_part,(PhyloNode*)nei1_part->node);
+        } else {
+            if (part_info[part].cur_score == 0.0)
+                part_info[part].cur_score = at(part)->computeLikelihood();
+        }
+        return part_info[part].cur_score;
+    }, true);
     return -tree_lh;
 }
 
@@ -361,10 +349,6 @@ double PhyloSuperTreePlen::computeLikelihoodFromBuffer() {
 
 void PhyloSuperTreePlen::computeFuncDerv(double value, double &df_ret, double &ddf_ret) {
 //	double tree_lh = 0.0;
-	double df = 0.0;
-	double ddf = 0.0;
-
-	int ntrees = size();
 
 	if (!central_partial_lh) initializeAllPartialLh();
 
@@ -376,19 +360,16 @@ void PhyloSuperTreePlen::computeFuncDerv(double value, double &df_ret, double &d
 	SuperNeighbor *nei2 = (SuperNeighbor*)current_it->node->findNeighbor(current_it_back->node);
 	ASSERT(nei1 && nei2);
 
-    if (part_order.empty()) computePartitionOrder();
-    #ifdef _OPENMP
-    #pragma omp parallel for reduction(+: df, ddf) schedule(dynamic) if(num_threads > 1)
-    #endif    
-	for (int partid = 0; partid < ntrees; partid++) {
-        int part = part_order_by_nptn[partid];
+    // first and second derivatives summed over partitions
+    typedef pair<double, double> Derivatives;
+    Derivatives derv = reduceOverPartitions(Derivatives(0.0, 0.0), [&](int part) -> Derivatives {
         double df_aux, ddf_aux;
         PhyloNeighbor *nei1_part = nei1->link_neighbors[part];
         PhyloNeighbor *nei2_part = nei2->link_neighbors[part];
         if (nei1_part && nei2_part) {
             at(part)->current_it = nei1_part;
             at(part)->current_it_back = nei2_part;
-            
+        
             nei1_part->length += lambda*part_info[part].part_rate;
             nei2_part->length += lambda*part_info[part].part_rate;
             if(nei1_part->length<-1e-4) {
@@ -398,17 +379,20 @@ void PhyloSuperTreePlen::computeFuncDerv(double value, double &df_ret, double &d
                 outError("shit!!   ",__func__);
             }
             at(part)->computeLikelihoodDerv(nei2_part,(PhyloNode*)nei1_part->node, &df_aux, &ddf_aux);
-            df += part_info[part].part_rate*df_aux;
-            ddf += part_info[part].part_rate*part_info[part].part_rate*ddf_aux;
+            return Derivatives(part_info[part].part_rate*df_aux,
+                               part_info[part].part_rate*part_info[part].part_rate*ddf_aux);
         }
         else {
             if (part_info[part].cur_score == 0.0) {
                 part_info[part].cur_score = at(part)->computeLikelihood();
             }
+            return Derivatives(0.0, 0.0);
         }
-    }
-    df_ret = -df;
-    ddf_ret = -ddf;
+    }, [](const Derivatives &a, const Derivatives &b) {
+        return Derivatives(a.first + b.first, a.second + b.second);
+    }, true);
+    df_ret = -derv.first;
+    ddf_ret = -derv.second;
 }
 
 NNIMove PhyloSuperTreePlen::getBestNNIForBran(PhyloNode *node1, PhyloNode *node2, NNIMove *nniMoves)
@@ -21,6 +21,7 @@
  ***************************************************************************/
 #include "phylotree.h"
 #include "utils/starttree.h"
+#include "utils/sketchtree.h" //for StartTree::SketchTreeBuilder
 #include "utils/progress.h"  //for progress_display
 //#include "rateheterogeneity.h"
 #include "alignment/alignmentpairwise.h"
@@ -88,7 +89,11 @@ void PhyloTree::init() {
     central_scale_num = NULL;
     nni_scale_num = NULL;
     central_partial_pars = NULL;
+    preorder_partial_lh = NULL;
+    preorder_scale_num = NULL;
+    preorder_lh_slots = 0;
     cost_matrix = NULL;
+    pars_score_bound = UINT_MAX;
     model_factory = NULL;
     discard_saturated_site = true;
     _pattern_lh = NULL;
@@ -136,6 +141,8 @@ void PhyloTree::init() {
     safe_numeric = false;
     summary = nullptr;
     isSummaryBorrowed = false;
+    isDistanceStreamPending = false;
+    packed_dist_source = nullptr;
     progress = nullptr;
     progressStackDepth = 0;
 }
@@ -234,6 +241,8 @@ PhyloTree::~PhyloTree() {
     aligned_free(central_partial_lh);
     aligned_free(central_scale_num);
     aligned_free(central_partial_pars);
+    aligned_free(preorder_partial_lh);
+    aligned_free(preorder_scale_num);
     aligned_free(cost_matrix);
 
     delete model_factory;
@@ -257,6 +266,7 @@ PhyloTree::~PhyloTree() {
 
     delete[] var_matrix;
     var_matrix = NULL;
+    releasePackedDist();
 
     if (pllPartitions)
         myPartitionsDestroy(pllPartitions);
@@ -814,7 +824,9 @@ size_t PhyloTree::getBitsBlockSize() {
     // reserve the last entry for parsimony score
 //    return (aln->num_states * aln->size() + UINT_BITS - 1) / UINT_BITS + 1;
     if (cost_matrix) {
-        return get_safe_upper_limit_float(aln->size() * aln->num_states);
+        // the Sankoff kernels loop over all of aln->ordered_pattern, which is
+        // padded to get_safe_upper_limit_float(aln->size()) patterns
+        return get_safe_upper_limit_float(aln->size()) * aln->num_states;
     }
     size_t len = aln->getMaxNumStates() * ((max(aln->size(), (size_t)aln->num_variant_sites) + SIMD_BITS - 1) / UINT_BITS) + 4;
 #ifdef __AVX512KNL
@@ -939,6 +951,9 @@ void PhyloTree::deleteAllPartialLh() {
     aligned_free(central_partial_lh);
     aligned_free(central_scale_num);
     aligned_free(central_partial_pars);
+    aligned_free(preorder_partial_lh);
+    aligned_free(preorder_scale_num);
+    preorder_lh_slots = 0;
     aligned_free(nni_scale_num);
     aligned_free(nni_partial_lh);
     aligned_free(ptn_invar);
@@ -1017,6 +1032,12 @@ uint64_t PhyloTree::getMemoryRequired(size_t ncategory, bool full_mem) {
 
     // also count MEM for nni_partial_lh
     mem_size += (max_lh_slots+2) * lh_scale_size;
+
+    // pre-order partial likelihoods
+    if (preorder_partial_lh)
+        mem_size += preorder_lh_slots * lh_scale_size;
+    else if (params->optimize_brlen_lbfgs && params->lh_mem_save == LM_PER_NODE)
+        mem_size += 2 * (leafNum-2) * lh_scale_size;
     return mem_size;
 }
 
@@ -1181,6 +1202,92 @@ void PhyloTree::initializeAllPartialLh(int &index, int &indexlh, PhyloNode *node
     FOR_NEIGHBOR_IT(node, dad, it) initializeAllPartialLh(index, indexlh, (PhyloNode*) (*it)->node, node);
 }
 
+bool PhyloTree::initializePreorderPartialLh() {
+    if (params->lh_mem_save != LM_PER_NODE || isSuperTree() || isMixlen() || model->isSiteSpecificModel())
+        return false;
+    if (!central_partial_lh)
+        initializeAllPartialLh();
+    uint64_t block_size = getPartialLhSize();
+    uint64_t scale_block_size = block_size / model->num_states;
+
+    // one partial_lh per internal node is in central_partial_lh, the other directions towards it need their own
+    NodeVector nodes;
+    getInternalNodes(nodes);
+    int64_t num_slots = 0;
+    for (auto node : nodes)
+        num_slots += node->degree() - 1;
+    if (preorder_partial_lh && num_slots != preorder_lh_slots) {
+        deletePreorderPartialLh();
+    }
+    if (!preorder_partial_lh) {
+        if (verbose_mode >= VB_MAX)
+            cout << "Allocating " << num_slots * block_size * sizeof(double) << " bytes for pre-order partial likelihood vectors" << endl;
+        try {
+            preorder_partial_lh = aligned_alloc<double>(num_slots * block_size);
+            preorder_scale_num = aligned_alloc<UBYTE>(num_slots * scale_block_size);
+        } catch (std::bad_alloc &ba) {
+            outError("Not enough memory for pre-order partial likelihood vectors (bad_alloc)");
+        }
+        preorder_lh_slots = num_slots;
+    }
+    double *preorder_end = preorder_partial_lh + preorder_lh_slots * block_size;
+
+    int64_t slot = 0;
+    for (auto node : nodes) {
+        // the neighbor holding the region of central_partial_lh keeps it
+        PhyloNeighbor *central_nei = NULL;
+        FOR_NEIGHBOR_DECLARE(node, NULL, it) {
+            PhyloNeighbor *nei = (PhyloNeighbor*)(*it)->node->findNeighbor(node);
+            if (nei->partial_lh && (nei->partial_lh < preorder_partial_lh || nei->partial_lh >= preorder_end)) {
+                central_nei = nei;
+                break;
+            }
+        }
+        ASSERT(central_nei);
+        FOR_NEIGHBOR(node, NULL, it) {
+            PhyloNeighbor *nei = (PhyloNeighbor*)(*it)->node->findNeighbor(node);
+            if (nei == central_nei)
+                continue;
+            double *partial_lh = preorder_partial_lh + slot * block_size;
+            if (nei->partial_lh != partial_lh) {
+                nei->partial_lh = partial_lh;
+                nei->scale_num = preorder_scale_num + slot * scale_block_size;
+                nei->partial_lh_computed = 0;
+            }
+            slot++;
+        }
+    }
+    ASSERT(slot == preorder_lh_slots);
+    return true;
+}
+
+void PhyloTree::detachPreorderPartialLh() {
+    if (!preorder_partial_lh || !root)
+        return;
+    double *preorder_end = preorder_partial_lh + preorder_lh_slots * getPartialLhSize();
+    NodeVector nodes;
+    getInternalNodes(nodes);
+    for (auto node : nodes) {
+        FOR_NEIGHBOR_DECLARE(node, NULL, it) {
+            PhyloNeighbor *nei = (PhyloNeighbor*)(*it)->node->findNeighbor(node);
+            if (nei->partial_lh >= preorder_partial_lh && nei->partial_lh < preorder_end) {
+                nei->partial_lh = NULL;
+                nei->scale_num = NULL;
+                nei->partial_lh_computed = 0;
+            }
+        }
+    }
+}
+
+void PhyloTree::deletePreorderPartialLh() {
+    if (!preorder_partial_lh)
+        return;
+    detachPreorderPartialLh();
+    aligned_free(preorder_partial_lh);
+    aligned_free(preorder_scale_num);
+    preorder_lh_slots = 0;
+}
+
 double *PhyloTree::newPartialLh() {
     return aligned_alloc<double>(getPartialLhSize());
 }
@@ -2686,7 +2793,144 @@ void PhyloTree::computeBestTraversal(NodeVector &nodes, NodeVector &nodes2) {
     getPreOrderBranches(nodes, nodes2, farleaf);
 }
 
+void PhyloTree::computeAllBranchDerivatives(BranchVector &branches, DoubleVector &df, DoubleVector &ddf) {
+    branches.clear();
+    getBranches(branches);
+    df.resize(branches.size());
+    ddf.resize(branches.size());
+    // pre-order: the partial likelihoods towards a branch reuse those computed for its parent branch
+    for (size_t i = 0; i < branches.size(); i++) {
+        PhyloNode *node1 = (PhyloNode*)branches[i].first;
+        PhyloNode *node2 = (PhyloNode*)branches[i].second;
+        if (rooted && (node1 == root || node2 == root)) {
+            // virtual branch from root
+            df[i] = ddf[i] = 0.0;
+            continue;
+        }
+        current_it = (PhyloNeighbor*) node1->findNeighbor(node2);
+        current_it_back = (PhyloNeighbor*) node2->findNeighbor(node1);
+        theta_computed = false;
+        computeLikelihoodDerv(current_it, node1, &df[i], &ddf[i]);
+    }
+}
+
+/**
+    minus log-likelihood and its gradient as a function of all branch lengths,
+    for optimizeAllBranchesLBFGS(). Each variable is a branch length divided by a scale,
+    1/sqrt(-d2 logL/dt2) at the start, so that the problem is roughly equally curved
+    in every direction.
+ */
+class BranchLengthOptimization : public Optimization {
+public:
+    BranchLengthOptimization(PhyloTree *tree) : tree(tree) {
+        tree->computeAllBranchDerivatives(branches, df, ddf);
+        for (size_t i = 0; i < branches.size(); i++) {
+            if (tree->rooted && (branches[i].first == tree->root || branches[i].second == tree->root))
+                continue;
+            var_branches.push_back(i);
+            double len = branches[i].first->findNeighbor(branches[i].second)->length;
+            scale.push_back(ddf[i] < 0.0 ? 1.0/sqrt(-ddf[i]) : max(len, tree->params->min_branch_length));
+        }
+    }
+
+    /** number of branch lengths to optimize */
+    int getNVar() { return var_branches.size(); }
+
+    /** get the scaled length of each optimized branch */
+    void getVariables(double *x) {
+        for (size_t i = 0; i < var_branches.size(); i++) {
+            Branch &branch = branches[var_branches[i]];
+            x[i] = branch.first->findNeighbor(branch.second)->length / scale[i];
+        }
+    }
+
+    /** get the scaled bounds */
+    void getBounds(double *lower, double *upper) {
+        for (size_t i = 0; i < var_branches.size(); i++) {
+            lower[i] = tree->params->min_branch_length / scale[i];
+            upper[i] = tree->params->max_branch_length / scale[i];
+        }
+    }
+
+    /** set the length of each optimized branch from the scaled x and invalidate the partial likelihoods */
+    void setVariables(double *x) {
+        for (size_t i = 0; i < var_branches.size(); i++) {
+            Branch &branch = branches[var_branches[i]];
+            double len = x[i] * scale[i];
+            branch.first->findNeighbor(branch.second)->length = len;
+            branch.second->findNeighbor(branch.first)->length = len;
+        }
+        tree->clearAllPartialLH();
+    }
+
+    virtual double optimFunc(int, double *vars) {
+        setVariables(vars);
+        return -tree->computeLikelihood();
+    }
+
+    virtual double optimGradient(int, double *vars, double *gradient) {
+        setVariables(vars);
+        double tree_lh = tree->computeLikelihood();
+        tree->computeAllBranchDerivatives(branches, df, ddf);
+        for (size_t i = 0; i < var_branches.size(); i++)
+            gradient[i] = -df[var_branches[i]] * scale[i];
+        return -tree_lh;
+    }
+
+protected:
+    PhyloTree *tree;
+    BranchVector branches;
+    IntVector var_branches;
+    DoubleVector scale;
+    DoubleVector df, ddf;
+};
+
+double PhyloTree::optimizeAllBranchesLBFGS(int my_iterations, double tolerance) {
+    if (verbose_mode >= VB_MAX) {
+        cout << "Optimizing branch lengths by L-BFGS-B (max " << my_iterations << " iterations)..." << endl;
+    }
+    initializePreorderPartialLh();
+    DoubleVector lenvec;
+    saveBranchLengths(lenvec);
+    double tree_lh = computeLikelihood();
+    BranchLengthOptimization brlen_opt(this);
+    int nvar = brlen_opt.getNVar();
+    DoubleVector lower(nvar), upper(nvar), variables(nvar);
+    brlen_opt.getBounds(lower.data(), upper.data());
+    brlen_opt.getVariables(variables.data());
+    for (int i = 0; i < nvar; i++)
+        variables[i] = max(lower[i], min(upper[i], variables[i]));
+
+    // stop when an iteration improves the log-likelihood by less than tolerance
+    double factr = tolerance / (max(fabs(tree_lh), 1.0) * DBL_EPSILON);
+    brlen_opt.L_BFGS_B(nvar, variables.data(), lower.data(), upper.data(), 0.0, my_iterations, factr);
+    brlen_opt.setVariables(variables.data());
+    double new_tree_lh = computeLikelihood();
+    // keep the pool (like buffer_partial_lh) for the next call
+    detachPreorderPartialLh();
+
+    if (verbose_mode >= VB_MAX) {
+        cout << "Likelihood after L-BFGS-B: " << new_tree_lh << endl;
+    }
+    if (new_tree_lh < tree_lh - tolerance*0.1) {
+        // IN RARE CASE: tree log-likelihood decreases, revert the branch length
+        if (verbose_mode >= VB_MED) {
+            hideProgress();
+            cout << "NOTE: Restoring branch lengths as tree log-likelihood decreases after branch length optimization: "
+                << tree_lh << " -> " << new_tree_lh << endl;
+            showProgress();
+        }
+        clearAllPartialLH();
+        restoreBranchLengths(lenvec);
+        new_tree_lh = computeLikelihood();
+    }
+    curScore = new_tree_lh;
+    return new_tree_lh;
+}
+
 double PhyloTree::optimizeAllBranches(int my_iterations, double tolerance, int maxNRStep) {
+    if (params->optimize_brlen_lbfgs && initializePreorderPartialLh())
+        return optimizeAllBranchesLBFGS(my_iterations, tolerance);
     if (verbose_mode >= VB_MAX) {
         cout << "Optimizing branch lengths (max " << my_iterations << " loops)..." << endl;
     }
@@ -3260,6 +3504,13 @@ const int* PhyloTree::getConvertedSequenceNonConstFrequencies() const {
     return summary->nonConstSiteFrequencies.data();
 }
 
+size_t PhyloTree::getSumOfConvertedSequenceNonConstFrequencies() const {
+    if (summary==nullptr) {
+        return 0;
+    }
+    return summary->totalFrequencyOfNonConstSites;
+}
+
 int  PhyloTree::getSumOfFrequenciesForSitesWithConstantState(int state) const {
     if (summary==nullptr) {
         return 0;
@@ -3339,18 +3590,66 @@ double PhyloTree::correctDist(double *dist_mat) {
     return longest_dist;
 }
 
-template <class L, class F> double computeDistanceMatrix
-    ( LEAST_SQUARE_VAR vartype
-    , L unknown, const L* sequenceMatrix, int nseqs, int seqLen
-    , double denominator, const F* frequencyVector
-    , bool uncorrected, double num_states
+namespace {
+    template <class L, class F> class SequenceMatrixHamming {
+        //Hamming distances between rows of a sequence matrix
+        //L is the character type
+        //sequenceMatrix is nseqs rows of seqLen characters
+        //F is the frequency count type
+    protected:
+        L        unknown;
+        const L* sequenceMatrix;
+        int      seqLen;
+        const F* frequencyVector;
+    public:
+        SequenceMatrixHamming(L unknownState, const L* sequences, int length,
+                              const F* frequencies)
+            : unknown(unknownState), sequenceMatrix(sequences)
+            , seqLen(length), frequencyVector(frequencies) {}
+        double getDistance(int seq1, int seq2, double& unknownFreq) const {
+            return hammingDistance ( unknown
+                                   , sequenceMatrix + (size_t)seq1 * seqLen
+                                   , sequenceMatrix + (size_t)seq2 * seqLen
+                                   , seqLen, frequencyVector, unknownFreq );
+        }
+    };
+
+    class PackedHamming {
+        //Hamming distances between bit-packed DNA sequences
+        //(see AlignmentSummary::constructPackedMatrix)
+    protected:
+        const AlignmentSummary& summary;
+        double totalWeight; //of the packed sites
+    public:
+        explicit PackedHamming(const AlignmentSummary& s): summary(s), totalWeight(0) {
+            for (int f : s.siteFrequencies) {
+                totalWeight += f;
+            }
+        }
+        double getDistance(int seq1, int seq2, double& unknownFreq) const {
+            uint64_t differences = 0;
+            uint64_t comparable  = 0;
+            packedHammingDistance ( summary.getPackedSequence(seq1)
+                                  , summary.getPackedSequence(seq2)
+                                  , summary.packedGroupStops.data()
+                                  , summary.packedGroupWeights.data()
+                                  , summary.packedGroupWeights.size()
+                                  , differences, comparable );
+            unknownFreq = totalWeight - (double)comparable;
+            return (double)differences;
+        }
+    };
+};
+
+template <class H> double computeDistanceMatrix
+    ( LEAST_SQUARE_VAR vartype, const H& calculator, int nseqs
+    , double denominator, bool uncorrected, double num_states
     , double *dist_mat, double *var_mat)
 {
     //
-    //L is the character type
-    //sequenceMatrix is nseqs rows of seqLen characters
+    //H calculates (frequency-weighted) Hamming distances,
+    //(see SequenceMatrixHamming and PackedHamming)
     //dist_mat and var_mat are as in computeDist
-    //F is the frequency count type
     //
     
     std::vector<double> rowMaxDistance;
@@ -3369,20 +3668,16 @@ template <class L, class F> double computeDistanceMatrix
         //results in the last few rows being allocated to some worker thread
         //just before the others finish... it won't be running
         //"all by itsef" for as long.
-        int      rowOffset     = nseqs * seq1;
+        size_t   rowOffset     = (size_t)nseqs * seq1;
         double*  distRow       = dist_mat       + rowOffset;
         double*  varRow        = var_mat        + rowOffset;
-        const L* thisSequence  = sequenceMatrix + seq1 * seqLen;
-        const L* otherSequence = thisSequence   + seqLen;
         double maxDistanceInRow = 0.0;
         for (int seq2 = seq1 + 1; seq2 < nseqs; ++seq2) {
             double d2l      = varRow[seq2];
             double distance = distRow[seq2];
             if ( 0.0 == distance ) {
                 double unknownFreq = 0;
-                double hamming =
-                    hammingDistance ( unknown, thisSequence, otherSequence
-                                    , seqLen, frequencyVector, unknownFreq );
+                double hamming = calculator.getDistance(seq1, seq2, unknownFreq);
                 if (0<hamming && unknownFreq < denominator) {
                     distance = hamming / (denominator - unknownFreq);
                     if (!uncorrected) {
@@ -3401,7 +3696,6 @@ template <class L, class F> double computeDistanceMatrix
             {
                 maxDistanceInRow = distance;
             }
-            otherSequence += seqLen;
         }
         rowMaxDistance[seq1] = maxDistanceInRow;
         progress += (nseqs - 1 - seq1);
@@ -3432,7 +3726,7 @@ template <class L, class F> double computeDistanceMatrix
     #pragma omp parallel for schedule(dynamic)
     #endif
     for ( int seq1 = nseqs-1; 0 <= seq1; --seq1 ) {
-        int     rowOffset = nseqs * seq1;
+        size_t  rowOffset = (size_t)nseqs * seq1;
         double* distRow   = dist_mat + rowOffset;
         double* varRow    = var_mat  + rowOffset;
         double* distCol   = dist_mat + seq1; //current entries in the columns
@@ -3523,73 +3817,125 @@ double PhyloTree::computeDist_Experimental(double *dist_mat, double *var_mat) {
         EX_TRACE("Done stock distance calculation");
         return longest; //computeDist(dist_mat, var_mat);
     }
+    double longest;
+    if (aln->seq_type == SEQ_DNA && s.constructPackedMatrix()) {
+        EX_TRACE("Determining distance matrix from bit-packed sequences"
+            << " (" << s.packedWordCount << " words per sequence)");
+        longest = computeDistanceMatrix
+            ( params->ls_var_type, PackedHamming(s), s.sequenceCount
+             , denominator, uncorrected, aln->num_states
+             , dist_mat, var_mat);
+        EX_TRACE("Longest distance was " << longest);
+        return longest;
+    }
     EX_TRACE("Constructing sequence-major matrix of states"
         << " at " << s.sequenceLength << " varying sites"
         << " for " << s.sequenceCount << " sequences");
     s.constructSequenceMatrix(true);
     EX_TRACE("Determining distance matrix with unknown " << aln->STATE_UNKNOWN);
     const int* frequencies = s.siteFrequencies.data();
-    double longest = computeDistanceMatrix
-        ( params->ls_var_type, static_cast<char>(aln->STATE_UNKNOWN)
-         , s.sequenceMatrix, s.sequenceCount, s.sequenceLength
-         , denominator, frequencies, aln->num_states
-         , uncorrected, dist_mat, var_mat);
+    longest = computeDistanceMatrix
+        ( params->ls_var_type
+         , SequenceMatrixHamming<char, int>
+             ( static_cast<char>(aln->STATE_UNKNOWN), s.sequenceMatrix
+             , s.sequenceLength, frequencies )
+         , s.sequenceCount, denominator
+         , uncorrected, aln->num_states, dist_mat, var_mat);
     EX_TRACE("Longest distance was " << longest);
     return longest;
 }
 
+namespace {
+    const size_t DISTANCE_TILE_SIZE = 64;
+        //Sequences per side of a tile of the distance matrix.
+        //The pattern states of the 2 x DISTANCE_TILE_SIZE sequences
+        //in a tile should fit in (per-core) cache.
+
+    struct DistanceTile {
+        size_t rowStart;
+        size_t colStart;
+        DistanceTile(size_t r, size_t c): rowStart(r), colStart(c) {}
+    };
+
+    void listDistanceTiles(size_t nseqs, std::vector<DistanceTile>& tiles) {
+        //Tiles on or above the diagonal, ordered so that
+        //the (cheaper) diagonal tiles of each block row come last
+        tiles.clear();
+        for (size_t r = 0; r < nseqs; r += DISTANCE_TILE_SIZE) {
+            for (size_t c = r + DISTANCE_TILE_SIZE; c < nseqs; c += DISTANCE_TILE_SIZE) {
+                tiles.emplace_back(r, c);
+            }
+        }
+        for (size_t r = 0; r < nseqs; r += DISTANCE_TILE_SIZE) {
+            tiles.emplace_back(r, r);
+        }
+    }
+
+    inline double varianceForDistance(LEAST_SQUARE_VAR vartype, double dist, double d2l) {
+        switch (vartype) {
+            case OLS:                  return 1.0;
+            case WLS_PAUPLIN:          return 0.0;
+            case WLS_FIRST_TAYLOR:     return dist;
+            case WLS_FITCH_MARGOLIASH: return dist * dist;
+            case WLS_SECOND_TAYLOR:    return -1.0 / d2l;
+            default:                   return 1.0;
+        }
+    }
+};
+
 double PhyloTree::computeDist(double *dist_mat, double *var_mat) {
     prepareToComputeDistances();
     size_t nseqs = aln->getNSeq();
     double longest_dist = 0.0;
     cout.precision(6);
     double baseTime = getRealTime();
+    std::vector<DistanceTile> tiles;
+    listDistanceTiles(nseqs, tiles);
+    int64_t tileCount = tiles.size();
+    std::vector<double> tileMaxDistance(tileCount, 0.0);
     progress_display progress(nseqs*(nseqs-1)/2, "Calculating distance matrix"); //zork
-    //compute the upper-triangle of distance matrix
+    //compute the distance matrix, tile by tile, writing both
+    //the upper-triangle cell and its mirror in the lower-triangle
     #ifdef _OPENMP
     #pragma omp parallel for schedule(dynamic)
     #endif
-    for (size_t seq1 = 0; seq1 < nseqs; ++seq1) {
+    for (int64_t t = 0; t < tileCount; ++t) {
         #ifdef _OPENMP
             int threadNum = omp_get_thread_num();
             AlignmentPairwise* processor = distanceProcessors[threadNum];
         #else
             AlignmentPairwise* processor = distanceProcessors[0];
         #endif
-        int rowStartPos = seq1 * nseqs;
-        for (size_t seq2=seq1+1; seq2 < nseqs; ++seq2) {
-            size_t sym_pos = rowStartPos + seq2;
-            double d2l = var_mat[sym_pos]; // moved here for thread-safe (OpenMP)
-            dist_mat[sym_pos] = processor->recomputeDist(seq1, seq2, dist_mat[sym_pos], d2l);
-            if (params->ls_var_type == OLS)
-                var_mat[sym_pos] = 1.0;
-            else if (params->ls_var_type == WLS_PAUPLIN)
-                var_mat[sym_pos] = 0.0;
-            else if (params->ls_var_type == WLS_FIRST_TAYLOR)
-                var_mat[sym_pos] = dist_mat[sym_pos];
-            else if (params->ls_var_type == WLS_FITCH_MARGOLIASH)
-                var_mat[sym_pos] = dist_mat[sym_pos] * dist_mat[sym_pos];
-            else if (params->ls_var_type == WLS_SECOND_TAYLOR)
-                var_mat[sym_pos] = -1.0 / d2l;
-        }
-        progress += (nseqs - seq1 - 1);
-    }
-    //cout << (getRealTime()-baseTime) << "s Copying to lower triangle" << endl;
-    //copy upper-triangle into lower-triangle and set diagonal = 0
-    for (size_t seq1 = 1; seq1 < nseqs; ++seq1) {
-        size_t rowStartPos = seq1 * nseqs;
-        size_t rowStopPos  = rowStartPos + seq1;
-        size_t colPos = seq1;
-        for (size_t rowPos = rowStartPos; rowPos<rowStopPos; ++rowPos, colPos+=nseqs) {
-            auto d = dist_mat[colPos];
-            dist_mat [ rowPos ] = d;
-            var_mat  [ rowPos ] = var_mat [ colPos ];
-            if (d > longest_dist) {
-                longest_dist = d;
+        const DistanceTile& tile = tiles[t];
+        size_t rowStop = min(tile.rowStart + DISTANCE_TILE_SIZE, nseqs);
+        size_t colStop = min(tile.colStart + DISTANCE_TILE_SIZE, nseqs);
+        size_t pairsDone = 0;
+        double maxDistanceInTile = 0.0;
+        for (size_t seq1 = tile.rowStart; seq1 < rowStop; ++seq1) {
+            size_t rowStartPos = seq1 * nseqs;
+            size_t seq2 = (tile.colStart <= seq1) ? (seq1 + 1) : tile.colStart;
+            for (; seq2 < colStop; ++seq2, ++pairsDone) {
+                size_t sym_pos = rowStartPos + seq2;
+                size_t mirror_pos = seq2 * nseqs + seq1;
+                double d2l  = var_mat[sym_pos]; // moved here for thread-safe (OpenMP)
+                double dist = processor->recomputeDist(static_cast<int>(seq1), static_cast<int>(seq2), dist_mat[sym_pos], d2l);
+                double var  = varianceForDistance(params->ls_var_type, dist, d2l);
+                dist_mat[sym_pos] = dist_mat[mirror_pos] = dist;
+                var_mat [sym_pos] = var_mat [mirror_pos] = var;
+                if (dist > maxDistanceInTile) {
+                    maxDistanceInTile = dist;
+                }
+            }
+            if (tile.colStart == tile.rowStart) {
+                dist_mat[rowStartPos + seq1] = 0.0;
+                var_mat [rowStartPos + seq1] = 0.0;
             }
         }
-        dist_mat [ rowStopPos] = 0.0;
-        var_mat  [ rowStopPos] = 0.0;
+        tileMaxDistance[t] = maxDistanceInTile;
+        progress += pairsDone;
+    }
+    for (int64_t t = 0; t < tileCount; ++t) {
+        longest_dist = max(longest_dist, tileMaxDistance[t]);
     }
     doneComputingDistances();
 
@@ -3602,6 +3948,143 @@ double PhyloTree::computeDist(double *dist_mat, double *var_mat) {
     return longest_dist;
 }
 
+template <class T> double PhyloTree::computePackedDist(PackedDistanceMatrix<T> &dist_mat) {
+    prepareToComputeDistances();
+    size_t nseqs = aln->getNSeq();
+    double longest_dist = 0.0;
+    std::vector<DistanceTile> tiles;
+    listDistanceTiles(nseqs, tiles);
+    int64_t tileCount = tiles.size();
+    std::vector<double> tileMaxDistance(tileCount, 0.0);
+    progress_display progress(nseqs*(nseqs-1)/2, "Calculating distance matrix");
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (int64_t t = 0; t < tileCount; ++t) {
+        #ifdef _OPENMP
+            AlignmentPairwise* processor = distanceProcessors[omp_get_thread_num()];
+        #else
+            AlignmentPairwise* processor = distanceProcessors[0];
+        #endif
+        const DistanceTile& tile = tiles[t];
+        size_t rowStop = min(tile.rowStart + DISTANCE_TILE_SIZE, nseqs);
+        size_t colStop = min(tile.colStart + DISTANCE_TILE_SIZE, nseqs);
+        size_t pairsDone = 0;
+        double maxDistanceInTile = 0.0;
+        for (size_t seq1 = tile.rowStart; seq1 < rowStop; ++seq1) {
+            size_t seq2 = (tile.colStart <= seq1) ? (seq1 + 1) : tile.colStart;
+            T* cell = dist_mat.getUpperRow(seq1) + (seq2 - seq1 - 1);
+            for (; seq2 < colStop; ++seq2, ++cell, ++pairsDone) {
+                double d2l  = 1.0;
+                double dist = processor->recomputeDist(static_cast<int>(seq1), static_cast<int>(seq2), 0.0, d2l);
+                *cell = static_cast<T>(dist);
+                if (dist > maxDistanceInTile) {
+                    maxDistanceInTile = dist;
+                }
+            }
+        }
+        tileMaxDistance[t] = maxDistanceInTile;
+        progress += pairsDone;
+    }
+    for (int64_t t = 0; t < tileCount; ++t) {
+        longest_dist = max(longest_dist, tileMaxDistance[t]);
+    }
+    progress.done();
+    doneComputingDistances();
+    return longest_dist;
+}
+
+namespace {
+    template <class T> class PackedDistanceSource: public StartTree::DistanceSource {
+        //Supplies (for a start tree builder) distances from a packed matrix
+    public:
+        PackedDistanceMatrix<T> matrix;
+        virtual void getDistanceRow(size_t row, size_t colStop,
+                                    double* distances) const {
+            for (size_t col = 0; col < colStop; ++col) {
+                distances[col] = (double) matrix.getDistance(row, col);
+            }
+        }
+    };
+
+    template <class T> StartTree::DistanceSource* computePackedDistanceSource
+        ( PhyloTree& tree, Params& params, double& longest_dist ) {
+        PackedDistanceSource<T>* source = new PackedDistanceSource<T>();
+        try {
+            source->matrix.setBackingFile(params.dist_backing_file);
+            source->matrix.setSize(tree.aln->getNSeq());
+            longest_dist = tree.computePackedDist(source->matrix);
+            tree.aln->printDist(tree.dist_file.c_str(), source->matrix);
+        } catch (...) {
+            delete source;
+            throw;
+        }
+        return source;
+    }
+};
+
+double PhyloTree::computePackedDist(Params &params, Alignment *alignment) {
+    this->params = &params;
+    aln = alignment;
+    decideDistanceFilePath(params);
+    //The square matrices are what the packed matrix replaces
+    delete[] dist_matrix;
+    dist_matrix = nullptr;
+    delete[] var_matrix;
+    var_matrix  = nullptr;
+    releasePackedDist();
+
+    double begin_time = getRealTime();
+    double longest_dist = 0.0;
+    try {
+        if (params.float_dist) {
+            packed_dist_source = computePackedDistanceSource<float>(*this, params, longest_dist);
+        } else {
+            packed_dist_source = computePackedDistanceSource<double>(*this, params, longest_dist);
+        }
+    } catch (std::string& str) {
+        outError(str);
+    }
+    distanceFileWritten = dist_file;
+    if (verbose_mode >= VB_MED) {
+        cout << "Packed distance calculation (and writing " << dist_file << ") took "
+             << getRealTime() - begin_time << " seconds" << endl;
+    }
+    return longest_dist;
+}
+
+void PhyloTree::releasePackedDist() {
+    delete packed_dist_source;
+    packed_dist_source = nullptr;
+}
+
+void PhyloTree::computeDistanceRow(size_t row, size_t colStop, double* distances) {
+    #ifdef _OPENMP
+        AlignmentPairwise* processor = distanceProcessors[omp_get_thread_num()];
+    #else
+        AlignmentPairwise* processor = distanceProcessors[0];
+    #endif
+    for (size_t col = 0; col < colStop; ++col) {
+        if (col == row) {
+            distances[col] = 0.0;
+            continue;
+        }
+        double d2l = 1.0;
+        distances[col] = processor->recomputeDist(static_cast<int>(row), static_cast<int>(col), 0.0, d2l);
+    }
+}
+
+void PhyloTree::prepareToStreamDist(Params &params, Alignment *alignment) {
+    this->params = &params;
+    aln = alignment;
+    decideDistanceFilePath(params);
+    delete[] dist_matrix;
+    dist_matrix = nullptr;
+    delete[] var_matrix;
+    var_matrix  = nullptr;
+    isDistanceStreamPending = true;
+}
+
 void PhyloTree::decideDistanceFilePath(Params& params) {
     dist_file = params.out_prefix;
     if (!model_factory) {
@@ -3648,6 +4131,10 @@ double PhyloTree::computeDist(Params &params, Alignment *alignment, double* &dis
 }
 
 void PhyloTree::printDistanceFile() {
+    if (dist_matrix == nullptr) {
+        //computePackedDist has already written dist_file
+        return;
+    }
     aln->printDist(dist_file.c_str(), dist_matrix);
     distanceFileWritten = dist_file.c_str();
 }
@@ -3655,6 +4142,39 @@ void PhyloTree::printDistanceFile() {
 double PhyloTree::computeObsDist(double *dist_mat) {
     size_t nseqs = aln->getNSeq();
     double longest_dist = 0.0;
+    if (aln->seq_type == SEQ_DNA && !aln->isSuperAlignment()) {
+        //Bit-parallel version (same results as Alignment::computeObsDist)
+        AlignmentSummary s(aln, false, true);
+        if (s.constructPackedMatrix()) {
+            PackedHamming hamming(s);
+            double constantSites = aln->getNSite() - aln->num_variant_sites;
+            std::vector<double> rowMaxDistance(nseqs, 0.0);
+            #ifdef _OPENMP
+            #pragma omp parallel for schedule(dynamic)
+            #endif
+            for (int64_t seq1 = 0; seq1 < (int64_t)nseqs; ++seq1) {
+                double* distRow = dist_mat + seq1 * nseqs;
+                double  maxDistanceInRow = 0.0;
+                distRow[seq1] = 0.0;
+                for (size_t seq2 = seq1 + 1; seq2 < nseqs; ++seq2) {
+                    double unknownFreq = 0;
+                    double diff  = hamming.getDistance(static_cast<int>(seq1), static_cast<int>(seq2), unknownFreq);
+                    double total = constantSites + s.totalFrequencyOfNonConstSites - unknownFreq;
+                    double dist  = (0 < total) ? (diff / total) : MAX_GENETIC_DIST;
+                    distRow[seq2] = dist;
+                    dist_mat[seq2 * nseqs + seq1] = dist;
+                    if (dist > maxDistanceInRow) {
+                        maxDistanceInRow = dist;
+                    }
+                }
+                rowMaxDistance[seq1] = maxDistanceInRow;
+            }
+            for (size_t seq1 = 0; seq1 < nseqs; ++seq1) {
+                longest_dist = max(longest_dist, rowMaxDistance[seq1]);
+            }
+            return longest_dist;
+        }
+    }
     #ifdef _OPENMP
     #pragma omp parallel for schedule(dynamic)
     #endif
@@ -3695,6 +4215,21 @@ double PhyloTree::computeObsDist(Params &params, Alignment *alignment, double* &
  compute BioNJ tree, a more accurate extension of Neighbor-Joining
  ****************************************************************************/
 
+namespace {
+    class PhyloTreeDistanceSource: public StartTree::DistanceSource {
+        //Calculates distances (for a start tree builder), a row at a time
+    protected:
+        PhyloTree& tree;
+    public:
+        explicit PhyloTreeDistanceSource(PhyloTree& treeToUse): tree(treeToUse) {
+        }
+        virtual void getDistanceRow(size_t row, size_t colStop,
+                                    double* distances) const {
+            tree.computeDistanceRow(row, colStop, distances);
+        }
+    };
+};
+
 void PhyloTree::computeBioNJ(Params &params) {
     string bionj_file = params.out_prefix;
     bionj_file += ".bionj";
@@ -3702,7 +4237,39 @@ void PhyloTree::computeBioNJ(Params &params) {
     auto treeBuilder
         = StartTree::Factory::getTreeBuilderByName
             ( params.start_tree_subtype_name);
-    bool wasDoneInMemory = false;
+    bool wasStreamed = false;
+    if (packed_dist_source != nullptr) {
+        //Load the packed distances straight into the builder's matrix
+        //(rather than reading them back from the distance file)
+        double start_time = getRealTime();
+        wasStreamed = treeBuilder->constructTreeFromSource
+            ( this->aln->getSeqNames(), *packed_dist_source, bionj_file);
+        releasePackedDist();
+        if (wasStreamed && verbose_mode >= VB_MED) {
+            cout << "Constructing " << treeBuilder->getName() << " tree"
+                << " (from packed distance matrix) took "
+                << (getRealTime()-start_time) << " sec." << endl;
+        }
+    } else if (isDistanceStreamPending) {
+        isDistanceStreamPending = false;
+        double start_time = getRealTime();
+        prepareToComputeDistances();
+        PhyloTreeDistanceSource source(*this);
+        wasStreamed = treeBuilder->constructTreeFromSource
+            ( this->aln->getSeqNames(), source, bionj_file);
+        doneComputingDistances();
+        if (wasStreamed) {
+            if (verbose_mode >= VB_MED) {
+                cout << "Computing distances for, and constructing, "
+                    << treeBuilder->getName() << " tree took "
+                    << (getRealTime()-start_time) << " sec." << endl;
+            }
+        } else {
+            //The tree builder can only read a distance file
+            computeDist(params, aln, dist_matrix, var_matrix);
+        }
+    }
+    bool wasDoneInMemory = wasStreamed;
 #ifdef _OPENMP
     omp_set_nested(true);
     #pragma omp parallel num_threads(2)
@@ -3712,7 +4279,7 @@ void PhyloTree::computeBioNJ(Params &params) {
     for (int thread=0; thread<2; ++thread) {
 #endif
         if (thread==0) {
-            if (!params.dist_file) {
+            if (!params.dist_file && !wasStreamed) {
                 //This will take longer
                 double write_begin_time = getRealTime();
                 printDistanceFile();
@@ -3766,6 +4333,69 @@ void PhyloTree::computeBioNJ(Params &params) {
     }
 }
 
+namespace {
+    class AlignmentSequenceSource: public StartTree::SequenceSource {
+        //Supplies the (unaligned) sequences of an alignment
+    protected:
+        Alignment* aln;
+    public:
+        explicit AlignmentSequenceSource(Alignment* alignment): aln(alignment) {
+        }
+        virtual size_t getSequenceCount() const {
+            return aln->getNSeq();
+        }
+        virtual std::string getSequenceName(size_t seq) const {
+            return aln->getSeqName(static_cast<int>(seq));
+        }
+        virtual int getStateCount() const {
+            return aln->num_states;
+        }
+        virtual size_t getMaximumSequenceLength() const {
+            return aln->getNSite();
+        }
+        virtual void getSequence(size_t seq, std::vector<int>& states) const {
+            states.clear();
+            size_t siteCount = aln->getNSite();
+            for (size_t site = 0; site < siteCount; ++site) {
+                int state = aln->at(aln->getPatternID(site))[seq];
+                if (state == aln->STATE_UNKNOWN) {
+                    continue;
+                }
+                states.push_back(state < aln->num_states ? state : -1);
+            }
+        }
+    };
+};
+
+void PhyloTree::computeSketchTree(Params &params) {
+    string sketch_file = params.out_prefix;
+    sketch_file += ".sketchtree";
+    Alignment* sketched = aln;
+    if (aln->isSuperAlignment()) {
+        sketched = ((SuperAlignment*)aln)->concatenateAlignments();
+    }
+    double start_time = getRealTime();
+    cout << "Computing approximate (sketch) tree..." << endl;
+    AlignmentSequenceSource  source(sketched);
+    StartTree::SketchTreeBuilder builder;
+    bool wasBuilt = builder.constructTree(source, sketch_file);
+    if (sketched != aln) {
+        delete sketched;
+    }
+    if (!wasBuilt) {
+        outError("Could not construct sketch tree; please use another starting tree");
+    }
+    if (verbose_mode >= VB_MED) {
+        cout << "Constructing sketch tree took "
+            << (getRealTime()-start_time) << " sec." << endl;
+    }
+    bool non_empty_tree = (root != NULL);
+    readTreeFile(sketch_file.c_str());
+    if (non_empty_tree) {
+        initializeAllPartialLh();
+    }
+}
+
 int PhyloTree::setNegativeBranch(bool force, double newlen, Node *node, Node *dad) {
     if (!node) node = root;
     int fixed = 0;
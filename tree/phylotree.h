@@ -47,8 +47,12 @@
 #include "constrainttree.h"
 #include "memslot.h"
 #include "utils/progress.h"
+#include "utils/distancematrix.h"
 
 class AlignmentPairwise;
+namespace StartTree {
+    class DistanceSource;
+}
 
 #define BOOT_VAL_FLOAT
 #define BootValType float
@@ -81,6 +85,10 @@ const double TOL_LIKELIHOOD_PARAMOPT = 0.001; // BQM: newly introduced for Model
 
 const int SPR_DEPTH = 2;
 
+/** site blocks (per thread) scored between checks against the parsimony
+    score bound, in computeParsimonyBranchFast and its SIMD variants */
+const int PARS_BOUND_CHUNK = 16;
+
 //using namespace Eigen;
 
 #ifndef ROUND_UP_TO_MULTIPLE
@@ -775,6 +783,27 @@ public:
      */
     virtual void initializeAllPartialLh(int &index, int &indexlh, PhyloNode *node = NULL, PhyloNode *dad = NULL);
 
+    /**
+            give every direction of every branch its own partial_lh (the pre-order or "outside"
+            partial likelihoods, next to the one kept per internal node in central_partial_lh),
+            so that partial likelihoods are no longer re-oriented and stay valid for all branches
+            at once. Call again after initializeAllPartialLh().
+            @return FALSE if not supported (only for LM_PER_NODE and a single tree)
+     */
+    bool initializePreorderPartialLh();
+
+    /**
+            return the directions that got pre-order partial likelihoods to re-orientation,
+            but keep preorder_partial_lh allocated (like buffer_partial_lh) for the next
+            initializePreorderPartialLh()
+     */
+    void detachPreorderPartialLh();
+
+    /**
+            detach (see detachPreorderPartialLh()) and de-allocate preorder_partial_lh
+     */
+    void deletePreorderPartialLh();
+
 
     /**
             clear all partial likelihood for a clean computation again
@@ -816,6 +845,13 @@ public:
      */
     double *tip_partial_lh;
     int tip_partial_lh_computed;
+
+    /**
+     * tip states for which per-branch tip tables are computed: all model states,
+     * the ambiguous states that occur in the alignment, and STATE_UNKNOWN.
+     * Updated together with tip_partial_lh.
+     */
+    IntVector tip_states;
     UINT *tip_partial_pars;
 
     bool ptn_freq_computed;
@@ -1090,6 +1126,14 @@ public:
 
     virtual void writeMarginalAncestralState(ostream &out, PhyloNode *node, double *ptn_ancestral_prob, int *ptn_ancestral_seq);
 
+    /**
+        format the ancestral state and state probabilities of every pattern once, in the number format of out,
+        so that sites sharing a pattern reuse the text
+        @param out stream the text will be written to
+        @param[out] ptn_str tab-separated, newline-terminated text for each pattern
+    */
+    void formatMarginalAncestralPatterns(ostream &out, double *ptn_ancestral_prob, int *ptn_ancestral_seq, StrVector &ptn_str);
+
     /**
         end computing ancestral sequence probability for an internal node by marginal reconstruction
     */
@@ -1366,6 +1410,38 @@ public:
      */
     int addTaxonMPFast(Node *added_taxon, Node *added_node, Node *node, Node *dad);
 
+    /**
+            improve the tree by parsimony SPR moves, pruning each subtree
+            and regrafting it on the best branch within radius branches of
+            where it was, until a round of moves no longer lowers the
+            parsimony score. Works only for a strictly bifurcating tree.
+            @param radius maximum regrafting distance (in branches)
+            @return parsimony score of the resulting tree
+     */
+    int optimizeParsimonySPR(int radius);
+
+    /**
+            used by optimizeParsimonySPR: prune the subtree (at subtree,
+            attached to the rest of the tree at attach) and regraft it on the
+            branch, within radius, that gives the lowest parsimony score
+            @param cur_score parsimony score of the tree
+            @return parsimony score after the move (cur_score, if no move was made)
+     */
+    int regraftSubtreeParsimony(Node *subtree, Node *attach, int radius, int cur_score);
+
+    /**
+            used by regraftSubtreeParsimony: parsimony score of the tree, with
+            the (pruned) subtree regrafted on the branch node-dad
+     */
+    int scoreSubtreeRegraft(Node *subtree, Node *attach, Node *node, Node *dad);
+
+    /**
+            get the branches within radius of node (not via dad), each as
+            (nearer end, further end), in pre-order
+     */
+    void getParsimonySPRTargets(Node *node, Node *dad, int radius,
+                                NodeVector &near_nodes, NodeVector &far_nodes);
+
     /**
         create a 3-taxon tree and return random taxon order
         @param[out] taxon_order random taxon order
@@ -1445,6 +1521,25 @@ public:
      */
     virtual double optimizeAllBranches(int my_iterations = 100, double tolerance = TOL_LIKELIHOOD, int maxNRStep = 100);
 
+    /**
+            optimize all branch lengths together by L-BFGS-B, using the full gradient from
+            computeAllBranchDerivatives() (called by optimizeAllBranches() with --bl-lbfgs)
+            @param my_iterations max number of L-BFGS-B iterations
+            @param tolerance stop when the log-likelihood improves by less than this
+            @return the likelihood of the tree
+     */
+    double optimizeAllBranchesLBFGS(int my_iterations = 100, double tolerance = TOL_LIKELIHOOD);
+
+    /**
+            compute first and second derivatives of the tree log-likelihood with respect to
+            every branch length in one pre-order sweep. Each partial likelihood is computed
+            only once if initializePreorderPartialLh() was called before.
+            @param[out] branches all branches of the tree, in pre-order
+            @param[out] df first derivative for each branch (0 for the virtual root branch)
+            @param[out] ddf second derivative for each branch (0 for the virtual root branch)
+     */
+    void computeAllBranchDerivatives(BranchVector &branches, DoubleVector &df, DoubleVector &ddf);
+
     void moveRoot(Node *node1, Node *node2);
 
     virtual double computeFundiLikelihood();
@@ -1689,7 +1784,9 @@ public:
     virtual const int* getConvertedSequenceFrequencies() const;
     
     virtual const int* getConvertedSequenceNonConstFrequencies() const;
-    
+
+    virtual size_t getSumOfConvertedSequenceNonConstFrequencies() const;
+
     virtual int  getSumOfFrequenciesForSitesWithConstantState(int state) const;
     
     virtual void doneComputingDistances();
@@ -1737,6 +1834,49 @@ public:
      */
     double computeObsDist(Params &params, Alignment *alignment, double* &dist_mat);
 
+    /**
+            compute distance matrix into packed (upper-triangular) storage, in tiles
+            of sequences, and write it to dist_file. dist_matrix and var_matrix are
+            released; the packed matrix is kept (until computeBioNJ or
+            releasePackedDist) and loaded directly by the start tree builder.
+            @param params program parameters (float_dist, dist_backing_file)
+            @param alignment input alignment
+            @return the longest distance
+     */
+    double computePackedDist(Params &params, Alignment *alignment);
+
+    /**
+            compute the upper triangle of the distance matrix, in tiles of sequences
+            @param dist_mat (OUT) packed distance matrix, sized for num_seqs sequences
+            @return the longest distance
+     */
+    template <class T> double computePackedDist(PackedDistanceMatrix<T> &dist_mat);
+
+    /**
+            free the packed distance matrix kept by computePackedDist (if any)
+     */
+    void releasePackedDist();
+
+    /**
+            compute the distances between sequence row and sequences 0 .. colStop-1
+            (may be called, for different rows, from several threads at once,
+            between prepareToComputeDistances() and doneComputingDistances())
+            @param row the sequence
+            @param colStop the number of distances to compute
+            @param distances (OUT) the distances
+     */
+    void computeDistanceRow(size_t row, size_t colStop, double* distances);
+
+    /**
+            defer the calculation of distances to computeBioNJ, which will
+            stream them, a row at a time, into the start tree builder's own
+            matrix. dist_matrix and var_matrix are released, and no distance
+            file is written (the distances are never all held at once).
+            @param params program parameters
+            @param alignment input alignment
+     */
+    void prepareToStreamDist(Params &params, Alignment *alignment);
+
     /**
             correct the distances to follow metric property of triangle inequalities.
             Using the Floyd alogrithm.
@@ -1755,6 +1895,14 @@ public:
      */
     void computeBioNJ(Params &params);
 
+    /**
+            compute an approximate starting tree, from MinHash sketches
+            of the sequences, without computing all pairwise distances
+            (for very large alignments); see utils/sketchtree.h
+            @param params program parameters
+     */
+    void computeSketchTree(Params &params);
+
     /**
         called by fixNegativeBranch to fix one branch
         @param branch_length new branch length
@@ -2388,6 +2536,16 @@ protected:
      */
     UINT *central_partial_pars;
 
+    /**
+            partial likelihoods and scaling event numbers for the directions of branches that
+            have no region in central_partial_lh, see initializePreorderPartialLh()
+     */
+    double *preorder_partial_lh;
+    UBYTE *preorder_scale_num;
+
+    /** number of partial_lh vectors in preorder_partial_lh */
+    int64_t preorder_lh_slots;
+
     virtual void reorientPartialLh(PhyloNeighbor* dad_branch, Node *dad);
 
     //----------- memory saving technique ------//
@@ -2472,6 +2630,11 @@ protected:
     /** current best parsimony score */
     UINT best_pars_score;
 
+    /** computeParsimonyBranch may stop counting (returning a score
+        that is at least this) once the score reaches this bound;
+        UINT_MAX except while candidate insertions are scored */
+    UINT pars_score_bound;
+
     /** cost_matrix for non-uniform parsimony */
     unsigned int * cost_matrix; // Sep 2016: store cost matrix in 1D array
 
@@ -2489,6 +2652,14 @@ protected:
     string distanceFileWritten;
         /** Is set if/when a distance file has been written*/
 
+    bool isDistanceStreamPending;
+        /** Is set (by prepareToStreamDist) if computeBioNJ is to
+            calculate distances as it loads them*/
+
+    StartTree::DistanceSource* packed_dist_source;
+        /** Packed distance matrix (set by computePackedDist), from which
+            computeBioNJ loads distances, or nullptr*/
+
     
     /** stack of tasks in progress (top of stack is innermost task) */
     progress_display* progress;
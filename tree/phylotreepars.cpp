@@ -254,47 +254,57 @@ int PhyloTree::computeParsimonyBranchFast(PhyloNeighbor *dad_branch, PhyloNode *
     UINT sum_end_node = (dad_branch->partial_pars[scoreid] + node_branch->partial_pars[scoreid]);
     UINT score = sum_end_node;
 
-    UINT lower_bound = best_pars_score;
-    if (branch_subst) lower_bound = INT_MAX;
-    switch (nstates) {
-    case 4:
+    UINT lower_bound = pars_score_bound;
+    if (branch_subst) lower_bound = UINT_MAX;
+
+    // score a chunk of words at a time (in parallel), adding each chunk to
+    // the shared score; chunks not yet started are skipped once the score
+    // reaches lower_bound (the candidate being scored can no longer win)
+    bool in_parallel = (nstates == 4) ? (nsites > 200) : (nsites > 800/nstates);
+    const int chunk = PARS_BOUND_CHUNK * 8;
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) if(in_parallel)
+    #endif
+    for (int start = 0; start < nsites; start += chunk) {
+        UINT cur_score;
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+: score) if(nsites>200)
+        #pragma omp atomic read
         #endif
-		for (int site = 0; site < nsites; ++site) {
-            size_t offset = 4*site;
-            UINT *x = dad_branch->partial_pars + offset;
-            UINT *y = node_branch->partial_pars + offset;
-			UINT w = (x[0] & y[0]) | (x[1] & y[1]) | (x[2] & y[2]) | (x[3] & y[3]);
-			w = ~w;
-			score += vml_popcnt(w);
-//            #ifndef _OPENMP
-//            if (score >= lower_bound)
-//                break;
-//            #endif
-		}
-		break;
-    default:
+        cur_score = score;
+        if (cur_score >= lower_bound)
+            continue;
+        int stop = min(start + chunk, nsites);
+        UINT chunk_score = 0;
+        switch (nstates) {
+        case 4:
+            for (int site = start; site < stop; ++site) {
+                size_t offset = 4*site;
+                UINT *x = dad_branch->partial_pars + offset;
+                UINT *y = node_branch->partial_pars + offset;
+                UINT w = (x[0] & y[0]) | (x[1] & y[1]) | (x[2] & y[2]) | (x[3] & y[3]);
+                w = ~w;
+                chunk_score += vml_popcnt(w);
+            }
+            break;
+        default:
+            for (int site = start; site < stop; ++site) {
+                size_t offset = nstates * site;
+                UINT *x = dad_branch->partial_pars + offset;
+                UINT *y = node_branch->partial_pars + offset;
+                int i;
+                UINT w = x[0] & y[0];
+                for (i = 1; i < nstates; i++) {
+                    w |= x[i] & y[i];
+                }
+                w = ~w;
+                chunk_score += vml_popcnt(w);
+            }
+            break;
+        }
         #ifdef _OPENMP
-        #pragma omp parallel for reduction(+: score) if(nsites > 800/nstates)
+        #pragma omp atomic
         #endif
-		for (int site = 0; site < nsites; ++site) {
-            size_t offset = nstates * site;
-            UINT *x = dad_branch->partial_pars + offset;
-            UINT *y = node_branch->partial_pars + offset;
-			int i;
-			UINT w = x[0] & y[0];
-			for (i = 1; i < nstates; i++) {
-				w |= x[i] & y[i];
-			}
-			w = ~w;
-			score += vml_popcnt(w);
-//            #ifndef _OPENMP
-//            if (score >= lower_bound)
-//                break;
-//            #endif
-		}
-		break;
+        score += chunk_score;
     }
     if (branch_subst)
         *branch_subst = score - sum_end_node;
@@ -826,10 +836,17 @@ int PhyloTree::computeParsimonyBranchSankoff(PhyloNeighbor *dad_branch, PhyloNod
     int nstates = aln->num_states;
     UINT i, j, ptn;
     UINT branch_pars = 0;
+
+    // every PARS_BOUND_CHUNK patterns, stop if the score has reached the
+    // bound (the candidate being scored can no longer win)
+    UINT lower_bound = pars_score_bound;
+    if (branch_subst) lower_bound = UINT_MAX;
     
     if (dad->isLeaf()) {
         // external node
         for (ptn = 0; ptn < aln->ordered_pattern.size(); ptn++){
+            if (ptn % PARS_BOUND_CHUNK == 0 && tree_pars >= lower_bound)
+                break;
             int ptn_start_index = ptn * nstates;
             UINT *node_branch_ptr = &tip_partial_pars[aln->ordered_pattern[ptn][dad->id]*nstates];
             UINT *dad_branch_ptr = &dad_branch->partial_pars[ptn_start_index];
@@ -850,6 +867,8 @@ int PhyloTree::computeParsimonyBranchSankoff(PhyloNeighbor *dad_branch, PhyloNod
     }  else {
         // internal node
         for (ptn = 0; ptn < aln->ordered_pattern.size(); ptn++){
+            if (ptn % PARS_BOUND_CHUNK == 0 && tree_pars >= lower_bound)
+                break;
             int ptn_start_index = ptn * nstates;
             UINT *node_branch_ptr = &node_branch->partial_pars[ptn_start_index];
             UINT *dad_branch_ptr = &dad_branch->partial_pars[ptn_start_index];
@@ -1215,7 +1234,8 @@ int PhyloTree::computeParsimonyTree(const char *out_prefix, Alignment *alignment
         added_node->addNeighbor((Node*) 2, -1.0);
 
         for (int nodeid = 0; nodeid < nodes1.size(); nodeid++) {
-        
+            // insertions that can't beat the best so far needn't be fully scored
+            pars_score_bound = best_pars_score;
             int score = addTaxonMPFast(new_taxon, added_node, nodes1[nodeid], nodes2[nodeid]);
             if (score < best_pars_score) {
                 best_pars_score = score;
@@ -1226,6 +1246,7 @@ int PhyloTree::computeParsimonyTree(const char *out_prefix, Alignment *alignment
         
         if (verbose_mode >= VB_MAX)
             cout << ", score = " << best_pars_score << endl;
+        pars_score_bound = UINT_MAX;
         // now insert the new node in the middle of the branch node-dad
         insertNode2Branch(added_node, target_node, target_dad);
 
@@ -1244,6 +1265,12 @@ int PhyloTree::computeParsimonyTree(const char *out_prefix, Alignment *alignment
     
     ASSERT(index == 4*leafNum-6);
 
+    // improve the stepwise-addition tree by SPR moves
+    // (they could break a constraint tree, so not if there is one)
+    if (params && params->pars_spr && params->sprDist > 0 && constraintTree.empty()) {
+        best_pars_score = optimizeParsimonySPR(params->sprDist);
+    }
+
     nodeNum = 2 * leafNum - 2;
     initializeTree();
     // parsimony tree is always unrooted
@@ -1294,6 +1321,157 @@ int PhyloTree::addTaxonMPFast(Node *added_taxon, Node* added_node, Node* node, N
 
 }
 
+/****************************************************************************
+ Parsimony SPR (for improving stepwise-addition parsimony trees)
+ ****************************************************************************/
+
+void PhyloTree::getParsimonySPRTargets(Node *node, Node *dad, int radius,
+                                       NodeVector &near_nodes, NodeVector &far_nodes) {
+    FOR_NEIGHBOR_IT(node, dad, it) {
+        near_nodes.push_back(node);
+        far_nodes.push_back((*it)->node);
+        if (radius > 1)
+            getParsimonySPRTargets((*it)->node, node, radius-1, near_nodes, far_nodes);
+    }
+}
+
+int PhyloTree::scoreSubtreeRegraft(Node *subtree, Node *attach, Node *node, Node *dad) {
+    // like addTaxonMPFast, but without invalidating the partial parsimony
+    // vectors inside the subtree (only subtree->attach is recomputed)
+    node->updateNeighbor(dad, attach, -1.0);
+    dad->updateNeighbor(node, attach, -1.0);
+    attach->updateNeighbor((Node*) 1, node, -1.0);
+    attach->updateNeighbor((Node*) 2, dad, -1.0);
+    PhyloNeighbor *to_node = (PhyloNeighbor*) attach->findNeighbor(node);
+    PhyloNeighbor *from_dad = (PhyloNeighbor*) dad->findNeighbor(attach);
+    to_node->partial_pars = from_dad->partial_pars;
+    to_node->partial_lh_computed = from_dad->partial_lh_computed;
+    PhyloNeighbor *to_dad = (PhyloNeighbor*) attach->findNeighbor(dad);
+    PhyloNeighbor *from_node = (PhyloNeighbor*) node->findNeighbor(attach);
+    to_dad->partial_pars = from_node->partial_pars;
+    to_dad->partial_lh_computed = from_node->partial_lh_computed;
+    PhyloNeighbor *subtree_nei = (PhyloNeighbor*) subtree->findNeighbor(attach);
+    subtree_nei->partial_lh_computed = 0;
+
+    int score = computeParsimonyBranch(subtree_nei, (PhyloNode*) subtree);
+
+    node->updateNeighbor(attach, dad);
+    dad->updateNeighbor(attach, node);
+    attach->updateNeighbor(node, (Node*) 1);
+    attach->updateNeighbor(dad, (Node*) 2);
+    // both directions of node-dad were computed (for the pruned tree)
+    ((PhyloNeighbor*) node->findNeighbor(dad))->partial_lh_computed |= 2;
+    ((PhyloNeighbor*) dad->findNeighbor(node))->partial_lh_computed |= 2;
+    return score;
+}
+
+int PhyloTree::regraftSubtreeParsimony(Node *subtree, Node *attach, int radius, int cur_score) {
+    ASSERT(attach->degree() == 3);
+    Node *left = NULL, *right = NULL;
+    FOR_NEIGHBOR_IT(attach, subtree, it) {
+        if (!left) left = (*it)->node; else right = (*it)->node;
+    }
+    NodeVector near_nodes, far_nodes;
+    getParsimonySPRTargets(left, attach, radius, near_nodes, far_nodes);
+    getParsimonySPRTargets(right, attach, radius, near_nodes, far_nodes);
+    if (near_nodes.empty())
+        return cur_score;
+
+    // subtree must be the first neighbor of attach (as for a new taxon)
+    for (size_t i = 1; i < attach->neighbors.size(); i++)
+        if (attach->neighbors[i]->node == subtree)
+            std::swap(attach->neighbors[0], attach->neighbors[i]);
+    // storage of attach->left and attach->right, reused after regrafting
+    UINT *left_pars = ((PhyloNeighbor*) attach->findNeighbor(left))->partial_pars;
+    UINT *right_pars = ((PhyloNeighbor*) attach->findNeighbor(right))->partial_pars;
+
+    // partial parsimony towards the pruning point (near the subtree)
+    // must be recomputed, for the pruned tree
+    for (size_t i = 0; i < near_nodes.size(); i++)
+        ((PhyloNeighbor*) far_nodes[i]->findNeighbor(near_nodes[i]))->partial_lh_computed = 0;
+
+    // prune the subtree: join left and right directly
+    left->updateNeighbor(attach, right, -1.0);
+    right->updateNeighbor(attach, left, -1.0);
+    attach->updateNeighbor(left, (Node*) 1);
+    attach->updateNeighbor(right, (Node*) 2);
+    ((PhyloNeighbor*) left->findNeighbor(right))->partial_lh_computed = 0;
+    ((PhyloNeighbor*) right->findNeighbor(left))->partial_lh_computed = 0;
+
+    int best_score = cur_score;
+    int best_target = -1;
+    for (size_t i = 0; i < near_nodes.size(); i++) {
+        // candidates that can't beat the best so far needn't be fully scored
+        pars_score_bound = best_score;
+        int score = scoreSubtreeRegraft(subtree, attach, near_nodes[i], far_nodes[i]);
+        if (score < best_score) {
+            best_score = score;
+            best_target = i;
+        }
+    }
+    pars_score_bound = UINT_MAX;
+
+    // regraft: on the best branch found, or back where it was
+    Node *node = (best_target < 0) ? left : near_nodes[best_target];
+    Node *dad = (best_target < 0) ? right : far_nodes[best_target];
+    node->updateNeighbor(dad, attach, -1.0);
+    dad->updateNeighbor(node, attach, -1.0);
+    attach->updateNeighbor((Node*) 1, node, -1.0);
+    attach->updateNeighbor((Node*) 2, dad, -1.0);
+    PhyloNeighbor *to_node = (PhyloNeighbor*) attach->findNeighbor(node);
+    PhyloNeighbor *to_dad = (PhyloNeighbor*) attach->findNeighbor(dad);
+    PhyloNeighbor *from_node = (PhyloNeighbor*) node->findNeighbor(attach);
+    PhyloNeighbor *from_dad = (PhyloNeighbor*) dad->findNeighbor(attach);
+    to_node->partial_pars = from_dad->partial_pars;
+    to_node->partial_lh_computed = from_dad->partial_lh_computed;
+    to_dad->partial_pars = from_node->partial_pars;
+    to_dad->partial_lh_computed = from_node->partial_lh_computed;
+    from_node->partial_pars = left_pars;
+    from_node->partial_lh_computed = 0;
+    from_dad->partial_pars = right_pars;
+    from_dad->partial_lh_computed = 0;
+    ((PhyloNeighbor*) subtree->findNeighbor(attach))->partial_lh_computed = 0;
+
+    if (best_target < 0) {
+        // tree is as it was; only the vectors recomputed for the pruned tree are stale
+        for (size_t i = 0; i < near_nodes.size(); i++)
+            ((PhyloNeighbor*) far_nodes[i]->findNeighbor(near_nodes[i]))->partial_lh_computed = 0;
+        return cur_score;
+    }
+    // anything that includes where the subtree was, or is now, is stale
+    ((PhyloNode*) left)->clearReversePartialLh(NULL);
+    ((PhyloNode*) right)->clearReversePartialLh(NULL);
+    ((PhyloNode*) attach)->clearReversePartialLh(NULL);
+    return best_score;
+}
+
+int PhyloTree::optimizeParsimonySPR(int radius) {
+    int score = computeParsimony();
+    if (radius < 1 || leafNum < 5)
+        return score;
+    for (int round = 1; ; round++) {
+        int round_score = score;
+        NodeVector nodes1, nodes2;
+        getBranches(nodes1, nodes2);
+        for (size_t i = 0; i < nodes1.size(); i++) {
+            // prune the subtree on either side of the branch
+            for (int side = 0; side < 2; side++) {
+                Node *subtree = side ? nodes2[i] : nodes1[i];
+                Node *attach = side ? nodes1[i] : nodes2[i];
+                // earlier moves in this round may have moved the branch
+                if (attach->isLeaf() || !attach->isNeighbor(subtree))
+                    continue;
+                score = regraftSubtreeParsimony(subtree, attach, radius, score);
+            }
+        }
+        if (verbose_mode >= VB_MAX)
+            cout << "Parsimony SPR round " << round << ": score = " << score << endl;
+        if (score >= round_score)
+            break;
+    }
+    return score;
+}
+
 void PhyloTree::extractBifurcatingSubTree(NeighborVec &removed_nei, NodeVector &attached_node, int *rand_stream) {
     NodeVector nodes;
     getMultifurcatingNodes(nodes);
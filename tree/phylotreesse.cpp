@@ -254,6 +254,35 @@ void PhyloTree::computeTipPartialLikelihood() {
 	// for +I model
 	computePtnInvar();
 
+    // tip tables are only needed for states that occur: per-branch tables for the
+    // 14 (DNA) or 3 (protein) unused ambiguous states dominate short partitions.
+    // PoMo data with weighted sampling only has sampled states (>= num_states),
+    // so the 4+6*(N-1) model states need no tables either
+    int num_states = getModel()->num_states;
+    bool all_model_states = (aln->seq_type != SEQ_POMO);
+    vector<bool> state_occurs(aln->STATE_UNKNOWN+1, false);
+    int num_occurs = 0;
+    for (int state = 0; state <= aln->STATE_UNKNOWN; state++)
+        if ((all_model_states && state < num_states) || state == aln->STATE_UNKNOWN) {
+            state_occurs[state] = true;
+            num_occurs++;
+        }
+    // ambiguous states occurring in the alignment (stop as soon as all states occur)
+    for (auto pit = aln->begin(); pit != aln->end() && num_occurs <= aln->STATE_UNKNOWN; pit++)
+        for (auto sit = pit->begin(); sit != pit->end(); sit++)
+            if (*sit <= aln->STATE_UNKNOWN && !state_occurs[*sit]) {
+                state_occurs[*sit] = true;
+                num_occurs++;
+            }
+    for (auto pit = model_factory->unobserved_ptns.begin(); pit != model_factory->unobserved_ptns.end(); pit++)
+        for (auto sit = pit->begin(); sit != pit->end(); sit++)
+            if (*sit <= aln->STATE_UNKNOWN)
+                state_occurs[*sit] = true;
+    tip_states.clear();
+    for (int state = 0; state <= aln->STATE_UNKNOWN; state++)
+        if (state_occurs[state])
+            tip_states.push_back(state);
+
     if (getModel()->isSiteSpecificModel()) {
         // TODO: THIS NEEDS TO BE CHANGED TO USE ModelSubst::computeTipLikelihood()
 //        ModelSet *models = (ModelSet*)model;
@@ -1467,11 +1496,14 @@ void PhyloTree::computeMarginalAncestralState(PhyloNeighbor *dad_branch, PhyloNo
     // compute _pattern_lh_cat_state using NONREV kernel
     computeLikelihoodBranch(dad_branch, dad);
 
-    double *lh_state = _pattern_lh_cat_state;
     memset(ptn_ancestral_prob, 0, sizeof(double)*nptn*nstates);
 
     // convert vector_size into continuous pattern
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(num_threads) if(num_threads > 1)
+#endif
     for (size_t ptn = 0; ptn < nptn; ptn += vector_size) {
+        double *lh_state = _pattern_lh_cat_state + ptn*ncat_mix*nstates;
         double *state_prob = ptn_ancestral_prob + ptn*nstates;
         for (size_t c = 0; c < ncat_mix; c++) {
             for (size_t i = 0; i < nstates; i++) {
@@ -1485,6 +1517,9 @@ void PhyloTree::computeMarginalAncestralState(PhyloNeighbor *dad_branch, PhyloNo
     }
 
     // now normalize to probability
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(num_threads) if(num_threads > 1)
+#endif
     for (size_t ptn = 0; ptn < nptn; ptn++) {
         double *state_prob = ptn_ancestral_prob + ptn*nstates;
         double sum = 0.0;
@@ -1508,22 +1543,38 @@ void PhyloTree::computeMarginalAncestralState(PhyloNeighbor *dad_branch, PhyloNo
 
 }
 
-void PhyloTree::writeMarginalAncestralState(ostream &out, PhyloNode *node, double *ptn_ancestral_prob, int *ptn_ancestral_seq) {
-    size_t nsites = aln->getNSite();
+void PhyloTree::formatMarginalAncestralPatterns(ostream &out, double *ptn_ancestral_prob, int *ptn_ancestral_seq, StrVector &ptn_str) {
+    size_t nptn = getAlnNPattern();
     size_t nstates = model->num_states;
-    for (size_t site = 0; site < nsites; ++site) {
-        int ptn = aln->getPatternID(site);
-        out << node->name << "\t" << site+1 << "\t";
+    // same conversion as operator<< with the flags and precision of out
+    const char *format = (out.flags() & ios::fixed) ? "\t%.*f" : ((out.flags() & ios::scientific) ? "\t%.*e" : "\t%.*g");
+    int precision = out.precision();
+    ptn_str.resize(nptn);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(num_threads) if(num_threads > 1 && nptn > 1000)
+#endif
+    for (size_t ptn = 0; ptn < nptn; ptn++) {
+        string &str = ptn_str[ptn];
+        char buf[64];
 //        if (params->print_ancestral_sequence == AST_JOINT)
-//            out << aln->convertStateBackStr(joint_ancestral_node[ptn]) << "\t";
-        out << aln->convertStateBackStr(ptn_ancestral_seq[ptn]);
+//            str = aln->convertStateBackStr(joint_ancestral_node[ptn]) + "\t";
+        str = aln->convertStateBackStr(ptn_ancestral_seq[ptn]);
         double *state_prob = ptn_ancestral_prob + ptn*nstates;
         for (size_t j = 0; j < nstates; j++) {
-            out << "\t" << state_prob[j];
+            snprintf(buf, sizeof(buf), format, precision, state_prob[j]);
+            str += buf;
         }
-        out << endl;
+        str += '\n';
     }
+}
 
+void PhyloTree::writeMarginalAncestralState(ostream &out, PhyloNode *node, double *ptn_ancestral_prob, int *ptn_ancestral_seq) {
+    size_t nsites = aln->getNSite();
+    StrVector ptn_str;
+    formatMarginalAncestralPatterns(out, ptn_ancestral_prob, ptn_ancestral_seq, ptn_str);
+    for (size_t site = 0; site < nsites; ++site) {
+        out << node->name << "\t" << site+1 << "\t" << ptn_str[aln->getPatternID(site)];
+    }
 }
 
 void PhyloTree::endMarginalAncestralState(bool orig_kernel_nonrev, double* &ptn_ancestral_prob, int* &ptn_ancestral_seq) {
@@ -673,6 +673,9 @@ void finisheps(FILE *ofp, vector<SeqQuartetInfo> lmap_seq_quartet_info, int leaf
 //*** end of likelihood mapping stuff (imported from TREE-PUZZLE's lmap.c) (HAS)
 
 
+/** quartets handed to a thread at a time, in computeQuartetLikelihoods */
+const int64_t LMAP_QUARTET_BLOCK = 16;
+
 void PhyloTree::computeQuartetLikelihoods(vector<QuartetInfo> &lmap_quartet_info, QuartetGroups &LMGroups) {
 
     if (leafNum < 4) 
@@ -838,8 +841,10 @@ void PhyloTree::computeQuartetLikelihoods(vector<QuartetInfo> &lmap_quartet_info
     int *rstream = randstream;
 #endif    
 
+    // quartets are handed out in small blocks, as they become free, because
+    // their cost varies (with the number of sub-alignment patterns)
 #ifdef _OPENMP
-    #pragma omp for schedule(guided)
+    #pragma omp for schedule(dynamic, LMAP_QUARTET_BLOCK)
 #endif
     for (int64_t qid = 0; qid < params->lmap_num_quartets; qid++) { /*** draw lmap_num_quartets quartets randomly ***/
 	// fprintf(stderr, "%I64d\n", qid); 
@@ -924,7 +929,9 @@ void PhyloTree::computeQuartetLikelihoods(vector<QuartetInfo> &lmap_quartet_info
             quartet_tree->setParams(params);
             quartet_tree->optimize_by_newton = params->optimize_by_newton;
             quartet_tree->setLikelihoodKernel(params->SSE);
-            quartet_tree->setNumThreads(num_threads);
+            // each thread already works on its own quartets, so the
+            // patterns of a quartet are not split among threads
+            quartet_tree->setNumThreads(1);
 
             // set model and rate
             quartet_tree->setModelFactory(model_factory);
@@ -859,6 +859,12 @@ public:
          , const std::string & newickTreeFilePath) {
             return false;
     }
+    virtual bool constructTreeFromSource
+        ( const std::vector<std::string> &sequenceNames
+         , const StartTree::DistanceSource& /*source*/
+         , const std::string & newickTreeFilePath) {
+            return false;
+    }
     virtual void setZippedOutput(bool zipIt) {
         if (zipIt) {
             std::cerr << "Warning: BIONJ2009 does not support gzip output (or input)" << std::endl;
@@ -92,6 +92,13 @@ typedef Vec8f   FloatVector;
 typedef Vec8fb  FloatBoolVector;
 const   NJFloat infiniteDistance = 1e+36;
 const   int     notMappedToRow = -1;
+const   size_t  minimumRowsForParallelScan   = 256;
+    //Scans of the D matrix (to find row minima) are run
+    //on a single thread, if there are fewer rows than this.
+    //As n shrinks, starting threads costs more than they save.
+const   size_t  minimumRowsForParallelUpdate = 4096;
+    //Likewise, for updates of a single row (and column)
+    //of the D (or V) matrix (each of which is O(n)).
 
 namespace StartTree
 {
@@ -107,8 +114,8 @@ public:
     T       value;
     size_t  imbalance;
     Position() : row(0), column(0), value(0), imbalance(0) {}
-    Position(size_t r, size_t c, T v, size_t imbalance)
-        : row(r), column(c), value(v) {}
+    Position(size_t r, size_t c, T v, size_t imbalanceToUse)
+        : row(r), column(c), value(v), imbalance(imbalanceToUse) {}
     Position& operator = (const Position &rhs) {
         row       = rhs.row;
         column    = rhs.column;
@@ -117,8 +124,16 @@ public:
         return *this;
     }
     bool operator< ( const Position& rhs ) const {
-        return value < rhs.value
-        || (value == rhs.value && imbalance < rhs.imbalance);
+        //Ties (on value and imbalance) are broken by position,
+        //so that the same join is chosen, however many threads
+        //searched for it.
+        if (value != rhs.value) {
+            return value < rhs.value;
+        }
+        if (imbalance != rhs.imbalance) {
+            return imbalance < rhs.imbalance;
+        }
+        return row < rhs.row || (row == rhs.row && column < rhs.column);
     }
     bool operator<= ( const Position& rhs ) const {
         return value < rhs.value
@@ -451,7 +466,7 @@ public:
         //Remove row (and matching column) from a
         //square matrix, by swapping the last row
         //(and column) into its place.
-        #pragma omp parallel for
+        #pragma omp parallel for if(minimumRowsForParallelUpdate<=n)
         for (size_t r=0; r<n; ++r) {
             if (r!=rowNum) {
               T* rowData = rows[r];
@@ -466,7 +481,7 @@ public:
         const T* sourceRow = rows[n];
         rows[n] = nullptr;
         if (destRow!=sourceRow) {
-            #pragma omp parallel for
+            #pragma omp parallel for if(minimumRowsForParallelUpdate<=n)
             for (size_t c=0; c<n; ++c) {
                 destRow[c] = sourceRow[c];
             }
@@ -479,7 +494,7 @@ public:
             for (size_t r=1; r<n; ++r) {
                 destRow += w;
                 const T* sourceRow = rows[r];
-                #pragma omp parallel for
+                #pragma omp parallel for if(minimumRowsForParallelUpdate<=n)
                 for (size_t c=0; c<n; ++c) {
                     destRow[c] = sourceRow[c];
                 }
@@ -587,6 +602,46 @@ public:
         calculateRowTotals();
         return true;
     }
+    virtual bool loadMatrixFromSource(const std::vector<std::string>& names,
+                                      const DistanceSource& source) {
+        //Assumptions: as for loadMatrix.  Distances are requested
+        //a row at a time (the cells left of the diagonal) and
+        //written into the bottom-left triangle, which is then
+        //mirrored into the upper-right triangle.
+        setSize(names.size());
+        clusters.clear();
+        for (auto it = names.begin(); it != names.end(); ++it) {
+            clusters.addCluster(*it);
+        }
+        rowToCluster.resize(n, 0);
+        for (size_t r=0; r<n; ++r) {
+            rowToCluster[r]=r;
+        }
+        progress_display progress(n*(n-1)/2, "Calculating distance matrix", "calculated", "distance");
+        #pragma omp parallel
+        {
+            std::vector<double> distances(n, 0.0);
+            #pragma omp for schedule(dynamic)
+            for (size_t row=1; row<n; ++row) {
+                source.getDistanceRow(row, row, distances.data());
+                T* dest = rows[row];
+                for (size_t col=0; col<row; ++col) {
+                    dest[col] = (T) distances[col];
+                }
+                progress += row;
+            }
+        }
+        progress.done();
+        #pragma omp parallel for
+        for (size_t row=0; row<n; ++row) {
+            T* dest = rows[row];
+            for (size_t col=row+1; col<n; ++col) {
+                dest[col] = rows[col][row]; //U-R
+            }
+        }
+        calculateRowTotals();
+        return true;
+    }
     virtual bool constructTree() {
         Position<T> best;
         std::string taskName = "Constructing " + getAlgorithmName() + " tree";
@@ -616,7 +671,7 @@ protected:
         best.value = infiniteDistance;
         for (size_t r=0; r<n; ++r) {
             Position<T> & here = rowMinima[r];
-            if (here.value < best.value && here.row != here.column) {
+            if (here < best && here.row != here.column) {
                 best = here;
             }
         }
@@ -625,9 +680,9 @@ protected:
     {
         rowMinima.resize(n);
         rowMinima[0].value = infiniteDistance;
-        #pragma omp parallel for schedule(dynamic)
+        #pragma omp parallel for schedule(dynamic) if(minimumRowsForParallelScan<=n)
         for (size_t row=1; row<n; ++row) {
-            float  bestVrc    = infiniteDistance;
+            T      bestVrc    = infiniteDistance;
             size_t bestColumn = 0;
             const  T* rowData = rows[row];
             for (size_t col=0; col<row; ++col) {
@@ -670,6 +725,7 @@ protected:
         size_t tCount  = aCount + bCount;
         double lambda  = (double)aCount / (double)tCount;
         double mu      = 1.0 - lambda;
+        #pragma omp parallel for if(minimumRowsForParallelUpdate<=n)
         for (size_t i=0; i<n; ++i) {
             if (i!=a && i!=b) {
                 T Dai      = rows[a][i];
@@ -721,7 +777,7 @@ protected:
         scaledRowTotals.resize(n);
         T nless2      = ( n - 2 );
         T tMultiplier = ( n <= 2 ) ? 0 : (1 / nless2);
-        #pragma omp parallel for
+        #pragma omp parallel for if(minimumRowsForParallelUpdate<=n)
         for (size_t r=0; r<n; ++r) {
             scaledRowTotals[r] = rowTotals[r] * tMultiplier;
         }
@@ -737,18 +793,13 @@ protected:
         //      totals multiplied by (1/(T)(n-2)).
         //      Better n multiplications than n*(n-1)/2.
         //
-        T nless2      = ( n - 2 );
-        T tMultiplier = ( n <= 2 ) ? 0 : (1 / nless2);
         calculateScaledRowTotals();
-        T* tot = scaledRowTotals.data();
-        for (size_t r=0; r<n; ++r) {
-            tot[r] = rowTotals[r] * tMultiplier;
-        }
+        const T* tot = scaledRowTotals.data();
         rowMinima.resize(n);
         rowMinima[0].value = infiniteDistance;
-        #pragma omp parallel for schedule(dynamic)
+        #pragma omp parallel for schedule(dynamic) if(minimumRowsForParallelScan<=n)
         for (size_t row=1; row<n; ++row) {
-            float  bestVrc    = infiniteDistance;
+            T      bestVrc    = infiniteDistance;
             size_t bestColumn = 0;
             const T* rowData = rows[row];
             for (size_t col=0; col<row; ++col) {
@@ -776,7 +827,7 @@ protected:
         T lambda        = 0.5;
         T mu            = 1.0 - lambda;
         T dCorrection   = - lambda * aLength - mu * bLength;
-        #pragma omp parallel for
+        #pragma omp parallel for if(minimumRowsForParallelUpdate<=n)
         for (size_t i=0; i<n; ++i) {
             if (i!=a && i!=b) {
                 T Dai   = rows[a][i];
@@ -836,20 +887,48 @@ public:
         variance = *this;
         return rc;
     }
+    virtual bool loadMatrixFromSource(const std::vector<std::string>& names,
+                                      const DistanceSource& source) {
+        bool rc = super::loadMatrixFromSource(names, source);
+        variance = *this;
+        return rc;
+    }
+    T sumOfVarianceDifferences(size_t a, size_t b, size_t start, size_t stop) const {
+        //Sum of V[b][i]-V[a][i], for i in [start, stop), other than a and b
+        const T* rowA  = variance.rows[a];
+        const T* rowB  = variance.rows[b];
+        T        total = 0;
+        for (size_t i=start; i<stop; ++i) {
+            if (i!=a && i!=b) {
+                total += rowB[i] - rowA[i];
+            }
+        }
+        return total;
+    }
     inline T chooseLambda(size_t a, size_t b, T Vab) {
         //Assumed 0<=a<b<n
         T lambda = 0;
         if (Vab==0.0) {
             return 0.5;
         }
-        for (size_t i=0; i<a; ++i) {
-            lambda += variance.rows[b][i] - variance.rows[a][i];
-        }
-        for (size_t i=a+1; i<b; ++i) {
-            lambda += variance.rows[b][i] - variance.rows[a][i];
-        }
-        for (size_t i=b+1; i<n; ++i) {
-            lambda += variance.rows[b][i] - variance.rows[a][i];
+        if (n < minimumRowsForParallelUpdate) {
+            lambda = sumOfVarianceDifferences(a, b, 0, n);
+        } else {
+            //Partial sums, over fixed-width blocks, are added up in
+            //block order, so that lambda doesn't depend on the
+            //number of threads.
+            const size_t blockWidth = 1024;
+            size_t blockCount = (n + blockWidth - 1) / blockWidth;
+            std::vector<T> blockSums(blockCount, 0);
+            #pragma omp parallel for
+            for (size_t k=0; k<blockCount; ++k) {
+                size_t start = k * blockWidth;
+                size_t stop  = (start + blockWidth < n) ? (start + blockWidth) : n;
+                blockSums[k] = sumOfVarianceDifferences(a, b, start, stop);
+            }
+            for (size_t k=0; k<blockCount; ++k) {
+                lambda += blockSums[k];
+            }
         }
         lambda = 0.5 + lambda / (2.0*((T)n-2)*Vab);
         if (1.0<lambda) lambda=1.0;
@@ -870,7 +949,7 @@ public:
         T mu            = 1.0 - lambda;
         T dCorrection   = - lambda * aLength - mu * bLength;
         T vCorrection   = - lambda * mu * Vab;
-        #pragma omp parallel for
+        #pragma omp parallel for if(minimumRowsForParallelUpdate<=n)
         for (size_t i=0; i<n; ++i) {
             if (i!=a && i!=b) {
                 //Dci as per reduction 4 in [Gascuel]
@@ -1190,7 +1269,11 @@ public:
 
         decideOnRowScanningOrder();
         rowMinima.resize(n);
-        #pragma omp parallel for
+        //Rows are handed out one at a time (rather than in
+        //contiguous blocks), so that the most promising rows
+        //(which come first in rowScanOrder, and tighten qBest)
+        //are spread across the threads.
+        #pragma omp parallel for schedule(dynamic) if(minimumRowsForParallelScan<=n)
         for (size_t r=0; r<n; ++r) {
             size_t row             = rowScanOrder[r];
             size_t cluster         = rowToCluster[row];
@@ -1223,7 +1306,11 @@ public:
         const T*   rowData   = entriesSorted.rows[row];
         const int* toCluster = entryToCluster.rows[row];
         T Drc;
-        for (size_t i=0; (Drc=rowData[i])<rowBound; ++i) {
+        //Note: The bound is inclusive (and the sentinel checked
+        //      separately), so that a row holding an entry tied
+        //      for min(Q) is never ruled out by another thread
+        //      having found an equal entry first.
+        for (size_t i=0; (Drc=rowData[i])<infiniteDistance && Drc<=rowBound; ++i) {
             size_t  cluster = toCluster[i];
                 //The cluster associated with this distance
                 //The c in Qrc and Drc.
@@ -1288,7 +1375,7 @@ public:
         }
         rowMinima.resize(n);
         rowMinima[0].value = infiniteDistance;
-        #pragma omp parallel for schedule(dynamic)
+        #pragma omp parallel for schedule(dynamic) if(minimumRowsForParallelScan<=n)
         for (size_t row=1; row<n; ++row) {
             Position<T> pos(row, 0, infiniteDistance, 0);
             const T* rowData = rows[row];
@@ -1360,7 +1447,7 @@ public:
         T* nums = matrixAlign ( scratchColumnNumbers.data() );
         rowMinima.resize(n);
         rowMinima[0].value = infiniteDistance;
-        #pragma omp parallel for schedule(dynamic)
+        #pragma omp parallel for schedule(dynamic) if(minimumRowsForParallelScan<=n)
         for (size_t row=1; row<n; ++row) {
             Position<T> pos(row, 0, infiniteDistance, 0);
             const T* rowData = rows[row];
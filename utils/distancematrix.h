@@ -0,0 +1,212 @@
+//
+//  distancematrix.h
+//  iqtree
+//
+//  LICENSE:
+//* This program is free software; you can redistribute it and/or modify
+//* it under the terms of the GNU General Public License as published by
+//* the Free Software Foundation; either version 2 of the License, or
+//* (at your option) any later version.
+//*
+//* This program is distributed in the hope that it will be useful,
+//* but WITHOUT ANY WARRANTY; without even the implied warranty of
+//* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//* GNU General Public License for more details.
+//*
+//* You should have received a copy of the GNU General Public License
+//* along with this program; if not, write to the
+//* Free Software Foundation, Inc.,
+//* 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+//
+// PackedDistanceMatrix stores only the upper triangle (row < column)
+// of a symmetric distance matrix, row-major, so that the cells
+// (r, r+1) ... (r, n-1) of each row are contiguous.  That's
+// n*(n-1)/2 cells rather than n*n (and, with T=float, a quarter
+// of the memory of the square double matrices PhyloTree uses).
+//
+// Note 1: All offsets are 64-bit (uint64_t), so that matrices for more
+//         than 46,341 sequences (where n*n overflows a 32-bit int)
+//         can be addressed.
+// Note 2: If a backing file is set (via setBackingFile) before setSize
+//         is called, the cells are memory-mapped from that file (which
+//         is created, or truncated, and is removed again by clear()),
+//         so the operating system can page the matrix out to disk.
+//         On Windows the backing file is ignored, and the cells are
+//         always allocated on the heap.
+// Note 3: Distances are written out as square PHYLIP matrices
+//         (see writeRow), so downstream consumers of distance
+//         files needn't know about packing.  The start tree
+//         builders load them a row at a time, via a
+//         StartTree::DistanceSource (see PhyloTree::computeBioNJ).
+//
+
+#ifndef distancematrix_h
+#define distancematrix_h
+
+#include <cstddef>  //for size_t
+#include <cstdint>  //for uint64_t
+#include <cstdio>   //for remove
+#include <string>   //for std::string
+#include <ostream>  //for std::ostream
+#include <utility>  //for std::swap
+#if !defined(WIN32) && !defined(WIN64) && !defined(_WIN32)
+#define PACKED_DISTANCE_MATRIX_MMAP (1)
+#include <sys/mman.h> //for mmap, munmap
+#include <fcntl.h>    //for open
+#include <unistd.h>   //for ftruncate, close
+#else
+#define PACKED_DISTANCE_MATRIX_MMAP (0)
+#endif
+
+template <class T=double> class PackedDistanceMatrix
+{
+public:
+    typedef T        value_type;
+    typedef uint64_t Offset;
+protected:
+    size_t      rank;        //number of sequences (rows)
+    Offset      cellCount;   //rank*(rank-1)/2
+    T*          data;
+    bool        isMapped;    //true if data was mmapped from backingFile
+    std::string backingFile; //empty, if cells are on the heap
+public:
+    PackedDistanceMatrix(): rank(0), cellCount(0), data(nullptr), isMapped(false) {
+    }
+    PackedDistanceMatrix(const PackedDistanceMatrix& rhs) = delete;
+    PackedDistanceMatrix& operator=(const PackedDistanceMatrix& rhs) = delete;
+    ~PackedDistanceMatrix() {
+        clear();
+    }
+    void setBackingFile(const std::string& filePath) {
+        //Must be called before setSize (it doesn't move existing cells)
+        backingFile = filePath;
+    }
+    const std::string& getBackingFile() const {
+        return backingFile;
+    }
+    static Offset cellCountFor(size_t rankToUse) {
+        return (rankToUse < 2) ? 0 : ((Offset)rankToUse * (Offset)(rankToUse-1)) / 2;
+    }
+    static Offset bytesNeededFor(size_t rankToUse) {
+        return cellCountFor(rankToUse) * sizeof(T);
+    }
+    void setSize(size_t rankToUse) {
+        clear();
+        if (rankToUse < 2) {
+            rank = rankToUse;
+            return;
+        }
+        Offset cells = cellCountFor(rankToUse);
+        Offset bytes = cells * sizeof(T);
+        #if (PACKED_DISTANCE_MATRIX_MMAP)
+        if (!backingFile.empty()) {
+            int fd = open(backingFile.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+            if (fd < 0) {
+                throw std::string("Could not create distance matrix backing file ") + backingFile;
+            }
+            if (ftruncate(fd, (off_t)bytes) != 0) {
+                close(fd);
+                std::remove(backingFile.c_str());
+                throw std::string("Could not extend distance matrix backing file ") + backingFile;
+            }
+            void* mapped = mmap(nullptr, (size_t)bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd); //the mapping keeps the file open
+            if (mapped == MAP_FAILED) {
+                std::remove(backingFile.c_str());
+                throw std::string("Could not memory-map distance matrix backing file ") + backingFile;
+            }
+            data     = static_cast<T*>(mapped);
+            isMapped = true;
+        }
+        #endif
+        if (data == nullptr) {
+            data = new T[cells];
+        }
+        rank      = rankToUse;
+        cellCount = cells;
+        if (!isMapped) {
+            //(a freshly truncated backing file is already zeroed)
+            #ifdef _OPENMP
+            #pragma omp parallel for
+            #endif
+            for (int64_t i = 0; i < (int64_t)cellCount; ++i) {
+                data[i] = 0;
+            }
+        }
+    }
+    void clear() {
+        #if (PACKED_DISTANCE_MATRIX_MMAP)
+        if (isMapped) {
+            munmap(data, (size_t)(cellCount * sizeof(T)));
+            std::remove(backingFile.c_str());
+            data = nullptr;
+        }
+        #endif
+        delete [] data;
+        data      = nullptr;
+        isMapped  = false;
+        rank      = 0;
+        cellCount = 0;
+    }
+    size_t getSize() const {
+        return rank;
+    }
+    Offset getCellCount() const {
+        return cellCount;
+    }
+    bool isMemoryMapped() const {
+        return isMapped;
+    }
+    Offset getRowOffset(size_t row) const {
+        //Offset of cell (row, row+1).  Rows before row hold
+        //(rank-1) + (rank-2) + ... + (rank-row) cells.
+        return ((Offset)row * (Offset)(2*rank - row - 1)) / 2;
+    }
+    Offset getOffset(size_t row, size_t col) const {
+        //Assumes row != col
+        if (col < row) {
+            std::swap(row, col);
+        }
+        return getRowOffset(row) + (col - row - 1);
+    }
+    T* getUpperRow(size_t row) {
+        //Returns the address of cell (row, row+1); the cells
+        //for columns row+1 through rank-1 follow it.
+        return data + getRowOffset(row);
+    }
+    const T* getUpperRow(size_t row) const {
+        return data + getRowOffset(row);
+    }
+    T getDistance(size_t row, size_t col) const {
+        return (row == col) ? 0 : data[getOffset(row, col)];
+    }
+    void setDistance(size_t row, size_t col, T distance) {
+        if (row != col) {
+            data[getOffset(row, col)] = distance;
+        }
+    }
+    T getLongestDistance() const {
+        T longest = 0;
+        for (Offset i = 0; i < cellCount; ++i) {
+            if (longest < data[i]) {
+                longest = data[i];
+            }
+        }
+        return longest;
+    }
+    void writeRow(std::ostream& out, size_t row) const {
+        //Writes all rank distances in row (as though the
+        //matrix were square), each followed by a space.
+        //Cells left of the diagonal are read down column row.
+        for (size_t col = 0; col < row; ++col) {
+            out << (double)data[getRowOffset(col) + (row - col - 1)] << " ";
+        }
+        out << (double)0 << " ";
+        const T* upper = getUpperRow(row);
+        for (size_t col = row + 1; col < rank; ++col, ++upper) {
+            out << (double)(*upper) << " ";
+        }
+    }
+};
+
+#endif /* distancematrix_h */
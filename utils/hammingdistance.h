@@ -24,6 +24,8 @@
 #define HAMMING_VECTOR (1)
 #define VECTOR_MAD     (0)
 #include <vectorclass/vectorclass.h> //For Vec32c and Vec32cb classes
+#include <cstdint>                   //For uint64_t
+#include <cstddef>                   //For size_t
 
 //
 //Note 1: L is a template parameter so that, when the state range
@@ -118,4 +120,58 @@ inline double hammingDistance
 #endif
 
 
+//
+//Bit-parallel Hamming distances, for DNA sequences packed (64 sites
+//to a word) into three bit-planes: the high and low bits of the
+//(2-bit) state, and a mask of the sites at which the state is known
+//(one of A, C, G, T; gaps and ambiguous states are "unknown").
+//
+//Note 3: Each packed sequence is stored as wordCount triples of
+//        words (high bits, low bits, known mask), so that the
+//        planes for the same 64 sites are adjacent in memory.
+//Note 4: Sites are grouped by frequency (weight) when packed, and
+//        each group starts on a word boundary (padding sites are
+//        "unknown" in every sequence). Group g covers words
+//        [groupStops[g-1], groupStops[g]) and each site in it has
+//        weight groupWeights[g]. So weighting costs one multiply
+//        per group, rather than one add per site.
+//
+inline int popCount64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+inline void packedHammingDistance
+    ( const uint64_t* sequenceA, const uint64_t* sequenceB
+     , const size_t* groupStops, const int* groupWeights, size_t groupCount
+     , uint64_t& differences, uint64_t& comparable ) {
+    //On return, differences is the total weight of the sites
+    //at which both sequences have known, but different, states;
+    //comparable is the total weight of the sites at which both
+    //sequences have known states.
+    differences = 0;
+    comparable  = 0;
+    size_t word = 0;
+    for (size_t g = 0; g < groupCount; ++g) {
+        uint64_t groupDifferences = 0;
+        uint64_t groupComparable  = 0;
+        for (; word < groupStops[g]; ++word) {
+            const uint64_t* a = sequenceA + word * 3;
+            const uint64_t* b = sequenceB + word * 3;
+            uint64_t known    = a[2] & b[2];
+            uint64_t differ   = ( (a[0] ^ b[0]) | (a[1] ^ b[1]) ) & known;
+            groupDifferences += popCount64(differ);
+            groupComparable  += popCount64(known);
+        }
+        differences += groupDifferences * groupWeights[g];
+        comparable  += groupComparable  * groupWeights[g];
+    }
+}
+
 #endif /* hammingdistance_h */
@@ -1115,7 +1115,7 @@ double Optimization::minimizeNewton(double xmin, double xguess, double xmax, dou
 #undef JMAX*/
 
 
-double Optimization::L_BFGS_B(int n, double* x, double* l, double* u, double pgtol, int maxit) {
+double Optimization::L_BFGS_B(int n, double* x, double* l, double* u, double pgtol, int maxit, double factr) {
 	int i;
 	double Fmin;
 	int fail;
@@ -1130,7 +1130,7 @@ double Optimization::L_BFGS_B(int n, double* x, double* l, double* u, double pgt
 	for (i=0; i<n; i++)
 		nbd[i] = 2;
 
-	double factr = 1e+7; // control the convergence of the "L-BFGS-B" method.
+	// factr controls the convergence of the "L-BFGS-B" method.
 	// Convergence occurs when the reduction in the object is within this factor
 	// of the machine tolerance.
 	// Default is 1e7, that is a tolerance of about 1e-8
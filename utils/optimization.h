@@ -189,10 +189,11 @@ public:
      4. double* upper : upper bounds of the variables
      5. double pgtol: gradient tolerance
      5. int maxit : max # of iterations
+     6. double factr : stop when the relative reduction of the function is within factr times machine precision
      @return minimized function value
      After the function is invoked, the values of x will be updated
     */
-    double L_BFGS_B(int nvar, double* vars, double* lower, double* upper, double pgtol = 1e-5, int maxit = 5); // changed maxit 1000 -> 5 by Thomas on Sept 11, 15
+    double L_BFGS_B(int nvar, double* vars, double* lower, double* upper, double pgtol = 1e-5, int maxit = 5, double factr = 1e+7); // changed maxit 1000 -> 5 by Thomas on Sept 11, 15
 
     /** internal function called by L_BFGS_B
         should return function value 
@@ -0,0 +1,457 @@
+//
+//  sketchtree.cpp
+//
+//  LICENSE:
+//* This program is free software; you can redistribute it and/or modify
+//* it under the terms of the GNU General Public License as published by
+//* the Free Software Foundation; either version 2 of the License, or
+//* (at your option) any later version.
+//*
+//* This program is distributed in the hope that it will be useful,
+//* but WITHOUT ANY WARRANTY; without even the implied warranty of
+//* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//* GNU General Public License for more details.
+//*
+//* You should have received a copy of the GNU General Public License
+//* along with this program; if not, write to the
+//* Free Software Foundation, Inc.,
+//* 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+//
+
+#include "sketchtree.h"
+#include "progress.h"   //for progress_display
+#include <algorithm>    //for std::sort, std::unique, std::lower_bound
+#include <cmath>        //for log
+#include <fstream>      //for std::ofstream
+#include <iostream>     //for std::cerr
+#include <queue>        //for std::priority_queue
+
+namespace {
+    const uint64_t noHash  = ~(uint64_t)0;
+    const size_t   noChild = ~(size_t)0;
+    const double   maximumSketchDistance = 1.0;
+
+    inline uint64_t mixBits(uint64_t x) {
+        //The splitmix64 finalizer (so k-mer codes that differ
+        //only slightly have unrelated hashes)
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    struct SketchJoin {
+        double distance;
+        size_t a;
+        size_t b;
+        SketchJoin(double d, size_t x, size_t y)
+            : distance(d), a(x < y ? x : y), b(x < y ? y : x) {}
+        bool operator< (const SketchJoin& rhs) const {
+            //Reversed (std::priority_queue is a max-heap), and
+            //ties broken by cluster number, so joins are
+            //chosen in the same order for any thread count.
+            if (distance != rhs.distance) {
+                return rhs.distance < distance;
+            }
+            return rhs.a < a || (rhs.a == a && rhs.b < b);
+        }
+    };
+
+    struct SketchCluster {
+        size_t left;   //noChild, for a sequence
+        size_t right;
+        size_t size;   //number of sequences
+        double height; //half the (average) distance between the children
+    };
+
+    typedef std::vector<std::pair<size_t, double>> SketchAdjacency;
+
+    void removeDeadAdjacent(SketchAdjacency& adjacency, const std::vector<bool>& alive) {
+        size_t w = 0;
+        for (size_t r = 0; r < adjacency.size(); ++r) {
+            if (alive[adjacency[r].first]) {
+                adjacency[w++] = adjacency[r];
+            }
+        }
+        adjacency.resize(w);
+    }
+
+    void writeSubtree(std::ostream& out, const std::vector<SketchCluster>& clusters,
+                      const std::vector<std::string>& names, size_t root) {
+        //Iterative (rather than recursive), as the tree may be very deep
+        std::vector<std::pair<size_t, int>> stack; //cluster, next child
+        stack.emplace_back(root, 0);
+        while (!stack.empty()) {
+            size_t v = stack.back().first;
+            const SketchCluster& c = clusters[v];
+            bool finished = false;
+            if (c.left == noChild) {
+                out << names[v];
+                finished = true;
+            } else {
+                int state = stack.back().second++;
+                if (state == 0) {
+                    out << "(";
+                    stack.emplace_back(c.left, 0);
+                } else if (state == 1) {
+                    out << ",";
+                    stack.emplace_back(c.right, 0);
+                } else {
+                    out << ")";
+                    finished = true;
+                }
+            }
+            if (finished) {
+                stack.pop_back();
+                if (!stack.empty()) {
+                    out << ":" << (clusters[stack.back().first].height - c.height);
+                }
+            }
+        }
+    }
+};
+
+namespace StartTree
+{
+
+SketchTreeBuilder::SketchTreeBuilder(size_t sketchSizeToUse, size_t neighbourCountToUse)
+    : sketchSize(sketchSizeToUse), neighbourCount(neighbourCountToUse)
+    , maxBucketScan(64), kmerLength(0), sequenceCount(0) {
+}
+
+void SketchTreeBuilder::sketchSequences(const SequenceSource& source) {
+    sequenceCount = source.getSequenceCount();
+    size_t stateCount   = source.getStateCount();
+    size_t bitsPerState = 1;
+    while (((size_t)1 << bitsPerState) < stateCount) {
+        ++bitsPerState;
+    }
+    //The shortest k for which a k-mer has less than a 1% chance of
+    //turning up, at random, in a sequence of the maximum length
+    //(as per [OTB2016]), but no more than will fit in 60 bits.
+    double length  = (double)source.getMaximumSequenceLength();
+    double needed  = log(length * 99.0 + 1.0) / log((double)(stateCount < 2 ? 2 : stateCount));
+    size_t maxK    = 60 / bitsPerState;
+    kmerLength     = (size_t)ceil(needed);
+    kmerLength     = (kmerLength < 1) ? 1 : ((maxK < kmerLength) ? maxK : kmerLength);
+    uint64_t mask  = ((uint64_t)1 << (kmerLength * bitsPerState)) - 1;
+    sketches.assign(sequenceCount * sketchSize, noHash);
+    sketchLengths.assign(sequenceCount, 0);
+    progress_display progress(sequenceCount, "Sketching sequences", "sketched", "sequence");
+    #ifdef _OPENMP
+    #pragma omp parallel
+    #endif
+    {
+        std::vector<int>      states;
+        std::vector<uint64_t> hashes;
+        #ifdef _OPENMP
+        #pragma omp for schedule(dynamic)
+        #endif
+        for (int64_t seq = 0; seq < (int64_t)sequenceCount; ++seq) {
+            source.getSequence(seq, states);
+            hashes.clear();
+            uint64_t code = 0;
+            size_t   run  = 0; //unambiguous states in a row
+            for (int state : states) {
+                if (state < 0) {
+                    run  = 0;
+                    code = 0;
+                    continue;
+                }
+                code = ((code << bitsPerState) | (uint64_t)state) & mask;
+                if (kmerLength <= ++run) {
+                    hashes.push_back(mixBits(code));
+                }
+            }
+            std::sort(hashes.begin(), hashes.end());
+            hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+            size_t keep = (hashes.size() < sketchSize) ? hashes.size() : sketchSize;
+            std::copy(hashes.begin(), hashes.begin() + keep,
+                      sketches.begin() + seq * sketchSize);
+            sketchLengths[seq] = keep;
+            ++progress;
+        }
+    }
+    progress.done();
+}
+
+double SketchTreeBuilder::estimateDistance(size_t a, size_t b) const {
+    //Mash distance, from the Jaccard index estimated from the
+    //sketchSize smallest hashes in the union of the two sketches
+    const uint64_t* sketchA = sketches.data() + a * sketchSize;
+    const uint64_t* sketchB = sketches.data() + b * sketchSize;
+    size_t lengthA = sketchLengths[a];
+    size_t lengthB = sketchLengths[b];
+    size_t i = 0, j = 0, shared = 0, seen = 0;
+    while (seen < sketchSize && i < lengthA && j < lengthB) {
+        if (sketchA[i] == sketchB[j]) {
+            ++shared;
+            ++i;
+            ++j;
+        } else if (sketchA[i] < sketchB[j]) {
+            ++i;
+        } else {
+            ++j;
+        }
+        ++seen;
+    }
+    size_t leftOver = (lengthA - i) + (lengthB - j);
+    seen += (seen + leftOver < sketchSize) ? leftOver : (sketchSize - seen);
+    if (shared == 0) {
+        return maximumSketchDistance;
+    }
+    double jaccard  = (double)shared / (double)seen;
+    double distance = -log(2.0 * jaccard / (1.0 + jaccard)) / (double)kmerLength;
+    return (distance < maximumSketchDistance) ? distance : maximumSketchDistance;
+}
+
+void SketchTreeBuilder::findNeighbours
+    ( std::vector<std::vector<std::pair<size_t, double>>>& neighbours ) const {
+    //An index of (hash, sequence) pairs, sorted by hash, stands in
+    //for a hash table of sequences by sketch hash.
+    typedef std::pair<uint64_t, size_t> Entry;
+    std::vector<Entry> index;
+    for (size_t seq = 0; seq < sequenceCount; ++seq) {
+        const uint64_t* sketch = sketches.data() + seq * sketchSize;
+        for (size_t i = 0; i < sketchLengths[seq]; ++i) {
+            index.emplace_back(sketch[i], seq);
+        }
+    }
+    std::sort(index.begin(), index.end());
+    neighbours.clear();
+    neighbours.resize(sequenceCount);
+    progress_display progress(sequenceCount, "Finding candidate neighbours", "searched", "sequence");
+    #ifdef _OPENMP
+    #pragma omp parallel
+    #endif
+    {
+        std::vector<size_t>               hits;   //sequences sharing a hash
+        std::vector<std::pair<int, size_t>> ranked; //(-shared hashes, sequence)
+        #ifdef _OPENMP
+        #pragma omp for schedule(dynamic)
+        #endif
+        for (int64_t seq = 0; seq < (int64_t)sequenceCount; ++seq) {
+            hits.clear();
+            const uint64_t* sketch = sketches.data() + seq * sketchSize;
+            for (size_t i = 0; i < sketchLengths[seq]; ++i) {
+                uint64_t hash  = sketch[i];
+                auto     first = std::lower_bound(index.begin(), index.end(), Entry(hash, 0));
+                auto     self  = std::lower_bound(first, index.end(), Entry(hash, (size_t)seq));
+                //Look at the sequences either side of this one in the
+                //bucket (so that huge buckets, e.g. of near-identical
+                //sequences, don't all point to the same few sequences).
+                auto     back  = self;
+                auto     fore  = self + 1;
+                for (size_t scanned = 0; scanned < maxBucketScan; ) {
+                    bool more = false;
+                    if (first < back) {
+                        --back;
+                        hits.push_back(back->second);
+                        ++scanned;
+                        more = true;
+                    }
+                    if (fore < index.end() && fore->first == hash) {
+                        hits.push_back(fore->second);
+                        ++fore;
+                        ++scanned;
+                        more = true;
+                    }
+                    if (!more) {
+                        break;
+                    }
+                }
+            }
+            std::sort(hits.begin(), hits.end());
+            ranked.clear();
+            for (size_t h = 0; h < hits.size(); ) {
+                size_t other = hits[h];
+                size_t stop  = h;
+                while (stop < hits.size() && hits[stop] == other) {
+                    ++stop;
+                }
+                ranked.emplace_back(-(int)(stop - h), other);
+                h = stop;
+            }
+            size_t keep = (ranked.size() < neighbourCount) ? ranked.size() : neighbourCount;
+            std::partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end());
+            std::vector<std::pair<size_t, double>>& mine = neighbours[seq];
+            for (size_t r = 0; r < keep; ++r) {
+                size_t other = ranked[r].second;
+                mine.emplace_back(other, estimateDistance(seq, other));
+            }
+            ++progress;
+        }
+    }
+    progress.done();
+}
+
+bool SketchTreeBuilder::constructTree(const SequenceSource& source,
+                                      const std::string& newickTreeFilePath) {
+    size_t n = source.getSequenceCount();
+    if (n < 3) {
+        return false;
+    }
+    sketchSequences(source);
+    std::vector<std::vector<std::pair<size_t, double>>> neighbours;
+    findNeighbours(neighbours);
+    sketches.clear();
+    sketches.shrink_to_fit();
+
+    //Adjacency lists aren't purged of joined (dead) clusters as they
+    //are joined; dead entries are skipped, and a list is compacted when
+    //at least half of its entries are dead (deadCount), so that
+    //removal is amortized O(1).  slot maps a cluster to its entry in
+    //the adjacency list being built (or noChild), so that lists can be
+    //merged in time linear in their lengths, however high the degree
+    //(while the lists are first built, slot[x]==a marks x as already
+    //adjacent to a).
+    std::vector<SketchCluster>   clusters;
+    std::vector<SketchAdjacency> adjacent(n);
+    std::vector<bool>            alive(n, true);
+    std::vector<size_t>          deadCount(n + n - 1, 0);
+    std::vector<size_t>          slot(n + n - 1, noChild);
+    std::priority_queue<SketchJoin> joins;
+    clusters.reserve(n + n - 1);
+    for (size_t seq = 0; seq < n; ++seq) {
+        clusters.push_back(SketchCluster{noChild, noChild, 1, 0.0});
+    }
+    for (size_t a = 0; a < n; ++a) {
+        for (auto jt = adjacent[a].begin(); jt != adjacent[a].end(); ++jt) {
+            slot[jt->first] = a;
+        }
+        for (auto it = neighbours[a].begin(); it != neighbours[a].end(); ++it) {
+            size_t b = it->first;
+            if (slot[b] != a) {
+                slot[b] = a;
+                adjacent[a].emplace_back(b, it->second);
+                adjacent[b].emplace_back(a, it->second);
+                joins.push(SketchJoin(it->second, a, b));
+            }
+        }
+        std::vector<std::pair<size_t, double>>().swap(neighbours[a]);
+    }
+    std::fill(slot.begin(), slot.end(), noChild);
+    auto join = [&](size_t a, size_t b, double distance) -> size_t {
+        double height = distance * 0.5;
+        height = (height < clusters[a].height) ? clusters[a].height : height;
+        height = (height < clusters[b].height) ? clusters[b].height : height;
+        clusters.push_back(SketchCluster{a, b, clusters[a].size + clusters[b].size, height});
+        alive[a] = false;
+        alive[b] = false;
+        alive.push_back(true);
+        return clusters.size() - 1;
+    };
+
+    progress_display progress(n - 1, "Joining sketched clusters", "joined", "cluster");
+    double longest = 0.0;
+    while (!joins.empty()) {
+        SketchJoin best = joins.top();
+        joins.pop();
+        if (!alive[best.a] || !alive[best.b]) {
+            continue;
+        }
+        size_t a = best.a;
+        size_t b = best.b;
+        size_t c = join(a, b, best.distance);
+        longest  = (longest < best.distance) ? best.distance : longest;
+        //Average linkage, over the candidate neighbours of a and
+        //b (if only one of them has a distance to x, use that).
+        double sizeA = (double)clusters[a].size;
+        double sizeB = (double)clusters[b].size;
+        //(each live x adjacent to a or b has an entry, now dead, for each)
+        SketchAdjacency merged;
+        for (auto it = adjacent[a].begin(); it != adjacent[a].end(); ++it) {
+            if (alive[it->first]) {
+                slot[it->first] = merged.size();
+                merged.emplace_back(it->first, it->second);
+                ++deadCount[it->first];
+            }
+        }
+        for (auto it = adjacent[b].begin(); it != adjacent[b].end(); ++it) {
+            if (!alive[it->first]) {
+                continue;
+            }
+            size_t m = slot[it->first];
+            if (m != noChild) {
+                merged[m].second = (merged[m].second * sizeA + it->second * sizeB)
+                                 / (sizeA + sizeB);
+            } else {
+                merged.emplace_back(it->first, it->second);
+            }
+            ++deadCount[it->first];
+        }
+        SketchAdjacency().swap(adjacent[a]);
+        SketchAdjacency().swap(adjacent[b]);
+        for (auto it = merged.begin(); it != merged.end(); ++it) {
+            size_t x = it->first;
+            slot[x]  = noChild;
+            SketchAdjacency& theirs = adjacent[x];
+            if (theirs.size() <= deadCount[x] * 2) {
+                removeDeadAdjacent(theirs, alive);
+                deadCount[x] = 0;
+            }
+            theirs.emplace_back(c, it->second);
+            joins.push(SketchJoin(it->second, x, c));
+        }
+        adjacent.push_back(merged);
+        ++progress;
+    }
+    //Join whatever components the candidate graph didn't connect
+    std::vector<size_t> components;
+    for (size_t i = 0; i < clusters.size(); ++i) {
+        if (alive[i]) {
+            components.push_back(i);
+        }
+    }
+    size_t top = components.front();
+    for (size_t i = 1; i < components.size(); ++i) {
+        size_t other    = components[i];
+        double height   = (clusters[top].height < clusters[other].height)
+                        ? clusters[other].height : clusters[top].height;
+        double distance = (longest < height * 2.0) ? (height * 2.0) : longest;
+        top = join(top, other, distance);
+        ++progress;
+    }
+    progress.done();
+
+    std::vector<std::string> names(n);
+    for (size_t seq = 0; seq < n; ++seq) {
+        names[seq] = source.getSequenceName(seq);
+    }
+    //Write the (rooted) tree as an unrooted one, by replacing the
+    //root with a three-way split (the root's internal child's two
+    //children, and the root's other child).
+    const SketchCluster& root = clusters[top];
+    size_t inner = (clusters[root.left].left != noChild) ? root.left : root.right;
+    size_t outer = (inner == root.left) ? root.right : root.left;
+    size_t parts[3]   = { clusters[inner].left, clusters[inner].right, outer };
+    double lengths[3] = { clusters[inner].height - clusters[parts[0]].height
+                        , clusters[inner].height - clusters[parts[1]].height
+                        , (root.height - clusters[inner].height)
+                          + (root.height - clusters[outer].height) };
+    try {
+        std::ofstream out;
+        out.exceptions(std::ios::failbit | std::ios::badbit);
+        out.open(newickTreeFilePath.c_str(), std::ios_base::out);
+        out.precision(8);
+        out << "(";
+        for (int p = 0; p < 3; ++p) {
+            if (0 < p) {
+                out << ",";
+            }
+            writeSubtree(out, clusters, names, parts[p]);
+            out << ":" << lengths[p];
+        }
+        out << ");" << std::endl;
+        out.close();
+    } catch (std::ios::failure &) {
+        std::cerr << "IO error"
+            << " opening/writing file: " << newickTreeFilePath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} //namespace StartTree
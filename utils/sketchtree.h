@@ -0,0 +1,71 @@
+//
+//  sketchtree.h
+//
+//  LICENSE:
+//* This program is free software; you can redistribute it and/or modify
+//* it under the terms of the GNU General Public License as published by
+//* the Free Software Foundation; either version 2 of the License, or
+//* (at your option) any later version.
+//*
+//* This program is distributed in the hope that it will be useful,
+//* but WITHOUT ANY WARRANTY; without even the implied warranty of
+//* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//* GNU General Public License for more details.
+//*
+//* You should have received a copy of the GNU General Public License
+//* along with this program; if not, write to the
+//* Free Software Foundation, Inc.,
+//* 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+//
+// SketchTreeBuilder constructs an approximate starting tree, for very
+// large inputs, without calculating all n*(n-1)/2 distances:
+//   1. Each sequence is reduced to a bottom-s MinHash sketch (the s
+//      smallest hashes of its k-mers; see [OTB2016]).
+//   2. Sequences that share sketch hashes become candidate neighbours;
+//      each sequence keeps (up to) neighbourCount of them, those that
+//      share the most hashes.  Mash distances are estimated (from the
+//      sketches) only for those pairs.
+//   3. Clusters are joined, closest pair first, UPGMA-style (average
+//      linkage), over that sparse graph of candidate neighbours.
+//      Components that are still separate when the graph runs out of
+//      edges are joined last.
+// Memory and time are O(n*s) and O(n*s*log(n*s)), rather than O(n*n).
+//
+// Note 1: The tree is only a starting point (the ML search will
+//         re-optimize topology and branch lengths).
+// Note 2: [OTB2016] Ondov, Treangen, Melsted, et al. (2016), Mash: fast
+//         genome and metagenome distance estimation using MinHash.
+//         Genome Biology 17:132.
+//
+
+#ifndef sketchtree_h
+#define sketchtree_h
+
+#include "starttree.h" //for StartTree::SequenceSource
+#include <cstdint>     //for uint64_t
+#include <string>
+#include <vector>
+
+namespace StartTree
+{
+    class SketchTreeBuilder
+    {
+    protected:
+        size_t sketchSize;      //hashes kept per sequence
+        size_t neighbourCount;  //candidate neighbours kept per sequence
+        size_t maxBucketScan;   //sequences looked at, per shared hash
+        size_t kmerLength;      //set (from the state count) by sketchSequences
+        size_t sequenceCount;
+        std::vector<uint64_t> sketches;      //sketchSize hashes per sequence
+        std::vector<size_t>   sketchLengths; //(some sequences have fewer k-mers)
+
+        void   sketchSequences(const SequenceSource& source);
+        double estimateDistance(size_t a, size_t b) const;
+        void   findNeighbours(std::vector<std::vector<std::pair<size_t, double>>>& neighbours) const;
+    public:
+        SketchTreeBuilder(size_t sketchSizeToUse = 256, size_t neighbourCountToUse = 16);
+        bool constructTree(const SequenceSource& source, const std::string& newickTreeFilePath);
+    };
+}
+
+#endif /* sketchtree_h */
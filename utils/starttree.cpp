@@ -115,9 +115,53 @@ bool BenchmarkingTreeBuilder::constructTree
     ( const std::string &distanceMatrixFilePath
      , const std::string & newickTreeFilePath) {
         bool result = (!builders.empty());
+        #ifdef _OPENMP
+            int maxThreads = omp_get_max_threads();
+        #endif
         for (auto it=builders.begin(); it!=builders.end(); ++it) {
+            double startTime = getRealTime();
+            #ifdef _OPENMP
+                omp_set_num_threads(1);
+            #endif
             (*it)->setZippedOutput(isOutputToBeZipped);
-            result &= (*it)->constructTree(distanceMatrixFilePath, newickTreeFilePath);
+            (*it)->beSilent();
+            bool succeeded = (*it)->constructTree(distanceMatrixFilePath, newickTreeFilePath);
+            double elapsed = getRealTime() - startTime;
+            result &= succeeded;
+            if (succeeded) {
+                std::cout.precision(6);
+                std::cout << (*it)->getName() << " \t" << elapsed;
+                #ifdef _OPENMP
+                for (int t=2; t<=maxThreads; ++t) {
+                    omp_set_num_threads(t);
+                    startTime = getRealTime();
+                    result &= (*it)->constructTree(distanceMatrixFilePath, newickTreeFilePath);
+                    elapsed = getRealTime() - startTime;
+                    std::cout << "\t" << (elapsed);
+                }
+                #endif
+                std::cout << std::endl;
+            }
+        }
+        #ifdef _OPENMP
+            omp_set_num_threads(maxThreads);
+        #endif
+        return result;
+    }
+
+bool BenchmarkingTreeBuilder::constructTreeFromSource
+    ( const std::vector<std::string> &sequenceNames
+    , const DistanceSource& source
+    , const std::string & newickTreeFilePath) {
+        bool result = false;
+        for (auto it=builders.begin(); it!=builders.end(); ++it) {
+            double startTime = getRealTime();
+            (*it)->beSilent();
+            if ((*it)->constructTreeFromSource(sequenceNames, source, newickTreeFilePath)) {
+                result = true;
+                std::cout.precision(6);
+                std::cout << (*it)->getName() << " \t" << (getRealTime() - startTime) << std::endl;
+            }
         }
         return result;
     }
@@ -158,6 +202,9 @@ bool BenchmarkingTreeBuilder::constructTreeInMemory
                 std::cout << std::endl;
             }
         }
+        #ifdef _OPENMP
+            omp_set_num_threads(maxThreads);
+        #endif
         return true;
     }
 };
@@ -29,6 +29,44 @@
 
 namespace StartTree
 {
+    class DistanceSource
+    {
+        //Supplies rows of a distance matrix on demand (e.g. by
+        //calculating them from sequences), so that tree builders
+        //can load distances straight into their own D (and V)
+        //matrices.  Neither a square double matrix nor a distance
+        //file need be written.
+        //Note: getDistanceRow may be called (for different rows)
+        //      by several threads at once.
+    public:
+        virtual ~DistanceSource() {}
+        virtual void getDistanceRow(size_t row, size_t colStop,
+                                    double* distances) const = 0;
+            //Writes the distances between taxon row, and taxa
+            //0 through colStop-1, to distances[0..colStop-1].
+    };
+
+    class SequenceSource
+    {
+        //Supplies sequences (e.g. rows of an alignment) to tree
+        //builders that work from sequences rather than distances
+        //(see SketchTreeBuilder, in sketchtree.h).
+        //Note: getSequence may be called (for different sequences)
+        //      by several threads at once.
+    public:
+        virtual ~SequenceSource() {}
+        virtual size_t getSequenceCount() const = 0;
+        virtual std::string getSequenceName(size_t seq) const = 0;
+        virtual int  getStateCount() const = 0;
+        virtual size_t getMaximumSequenceLength() const = 0;
+            //An upper bound on the number of states getSequence
+            //writes (e.g. the number of sites in an alignment).
+        virtual void getSequence(size_t seq, std::vector<int>& states) const = 0;
+            //Writes the states of sequence seq, in order, with gaps
+            //left out, to states.  Unambiguous states are in the
+            //range [0, getStateCount()); ambiguous ones are -1.
+    };
+
     class BuilderInterface
     {
     public:
@@ -42,6 +80,10 @@ namespace StartTree
             ( const std::vector<std::string> &sequenceNames
              , double *distanceMatrix
              , const std::string & newickTreeFilePath) = 0;
+        virtual bool constructTreeFromSource
+            ( const std::vector<std::string> &sequenceNames
+             , const DistanceSource& source
+             , const std::string & newickTreeFilePath) = 0;
         virtual const std::string& getName() = 0;
         virtual const std::string& getDescription() = 0;
         virtual void beSilent() {}
@@ -144,6 +186,18 @@ namespace StartTree
                 builder.setZippedOutput(isOutputToBeZipped);
                 return builder.writeTreeFile(newickTreeFilePath);
         }
+        virtual bool constructTreeFromSource
+            ( const std::vector<std::string> &sequenceNames
+            , const DistanceSource& source
+            , const std::string & newickTreeFilePath) {
+                B builder;
+                if (!builder.loadMatrixFromSource(sequenceNames, source)) {
+                    return false;
+                }
+                constructTreeWith(builder);
+                builder.setZippedOutput(isOutputToBeZipped);
+                return builder.writeTreeFile(newickTreeFilePath);
+        }
     };
 
     class BenchmarkingTreeBuilder: public BuilderInterface
@@ -164,6 +218,10 @@ namespace StartTree
             ( const std::vector<std::string> &sequenceNames
             , double *distanceMatrix
              , const std::string & newickTreeFilePath);
+        virtual bool constructTreeFromSource
+            ( const std::vector<std::string> &sequenceNames
+            , const DistanceSource& source
+             , const std::string & newickTreeFilePath);
         virtual void setZippedOutput(bool zipIt);
     };
 }
@@ -1290,6 +1290,27 @@ void parseArg(int argc, char *argv[], Params &params) {
             if (strcmp(argv[cnt], "--no-experimental") == 0) {
                 params.experimental = false;
                 continue;
+            }
+            if (arg=="-dist-packed" || arg=="--dist-packed") {
+                params.packed_dist = true;
+                continue;
+            }
+            if (arg=="-dist-float" || arg=="--dist-float") {
+                params.packed_dist = true;
+                params.float_dist  = true;
+                continue;
+            }
+            if (arg=="-dist-mmap" || arg=="--dist-mmap") {
+                cnt++;
+                if (cnt >= argc)
+                    throw "Use --dist-mmap <backing_file>";
+                params.packed_dist = true;
+                params.dist_backing_file = argv[cnt];
+                continue;
+            }
+            if (arg=="-dist-stream" || arg=="--dist-stream") {
+                params.stream_dist = true;
+                continue;
             }
 			if (strcmp(argv[cnt], "-r") == 0) {
 				cnt++;
@@ -2497,17 +2518,19 @@ void parseArg(int argc, char *argv[], Params &params) {
 			if (strcmp(argv[cnt], "-starttree") == 0) {
 				cnt++;
 				if (cnt >= argc)
-					throw "Use -starttree BIONJ|PARS|PLLPARS";
+					throw "Use -starttree BIONJ|PARS|PLLPARS|SKETCH";
                 else if (strcmp(argv[cnt], "PARS") == 0)
 					params.start_tree = STT_PARSIMONY;
 				else if (strcmp(argv[cnt], "PLLPARS") == 0)
 					params.start_tree = STT_PLL_PARSIMONY;
+				else if (strcmp(argv[cnt], "SKETCH") == 0)
+					params.start_tree = STT_SKETCH;
                 else if (START_TREE_RECOGNIZED(argv[cnt])) {
                     params.start_tree_subtype_name = argv[cnt];
                     params.start_tree = STT_BIONJ;
                 }
                 else
-					throw "Invalid option, please use -starttree with BIONJ or PARS or PLLPARS";
+					throw "Invalid option, please use -starttree with BIONJ or PARS or PLLPARS or SKETCH";
 				continue;
 			}
 
@@ -3008,6 +3031,10 @@ void parseArg(int argc, char *argv[], Params &params) {
 				params.optimize_by_newton = false;
 				continue;
 			}
+			if (strcmp(argv[cnt], "-bllbfgs") == 0 || strcmp(argv[cnt], "--bl-lbfgs") == 0) {
+				params.optimize_brlen_lbfgs = true;
+				continue;
+			}
 			if (strcmp(argv[cnt], "-jointopt") == 0) {
 				params.optimize_model_rate_joint = true;
 				continue;
@@ -3631,6 +3658,17 @@ void parseArg(int argc, char *argv[], Params &params) {
 				params.print_ufboot_trees = 2;
 				continue;
 			}
+			if (strcmp(argv[cnt], "--boot-trees-bin") == 0) {
+				cnt++;
+				if (cnt >= argc)
+					throw "Use --boot-trees-bin 32|64";
+				params.print_ufboot_bin = convert_int(argv[cnt]);
+				if (params.print_ufboot_bin != 32 && params.print_ufboot_bin != 64)
+					throw "--boot-trees-bin must be 32 or 64";
+				if (!params.print_ufboot_trees)
+					params.print_ufboot_trees = 1;
+				continue;
+			}
 			if (strcmp(argv[cnt], "-bs") == 0) {
 				cnt++;
 				if (cnt >= argc)
@@ -4240,6 +4278,10 @@ void parseArg(int argc, char *argv[], Params &params) {
 				params.sprDist = convert_int(argv[cnt]);
 				continue;
 			}
+			if (strcmp(argv[cnt], "--pars-spr") == 0) {
+				params.pars_spr = true;
+				continue;
+			}
             
             if (strcmp(argv[cnt], "--mpcost") == 0) {
                 cnt++;
@@ -4274,11 +4316,13 @@ void parseArg(int argc, char *argv[], Params &params) {
                 }
 				cnt++;
 				if (cnt >= argc)
-					throw "Use -t,-te <start_tree | BIONJ | PARS | PLLPARS | RANDOM>";
+					throw "Use -t,-te <start_tree | BIONJ | PARS | PLLPARS | RANDOM | SKETCH>";
 				else if (strcmp(argv[cnt], "PARS") == 0)
 					params.start_tree = STT_PARSIMONY;
 				else if (strcmp(argv[cnt], "PLLPARS") == 0)
 					params.start_tree = STT_PLL_PARSIMONY;
+				else if (strcmp(argv[cnt], "SKETCH") == 0)
+					params.start_tree = STT_SKETCH;
                 else if (strcmp(argv[cnt], "RANDOM") == 0 || strcmp(argv[cnt], "RAND") == 0)
                 {
 					params.start_tree = STT_RANDOM_TREE;
@@ -5229,6 +5273,7 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  -s DIR               Directory of alignment files" << endl
     << "  --seqtype STRING     BIN, DNA, AA, NT2AA, CODON, MORPH (default: auto-detect)" << endl
     << "  -t FILE|PARS|RAND    Starting tree (default: 99 parsimony and BIONJ)" << endl
+    << "  -t SKETCH            Approximate (MinHash sketch) starting tree for huge inputs" << endl
     << "  -o TAX[,...,TAX]     Outgroup taxon (list) for writing .treefile" << endl
     << "  --prefix STRING      Prefix for all output files (default: aln/partition)" << endl
     << "  --seed NUM           Random seed number, normally used for debugging purpose" << endl
@@ -5270,6 +5315,7 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --nstop NUM          Number of unsuccessful iterations to stop (default: 100)" << endl
     << "  --perturb NUM        Perturbation strength for randomized NNI (default: 0.5)" << endl
     << "  --radius NUM         Radius for parsimony SPR search (default: 6)" << endl
+    << "  --pars-spr           Improve -t PARS tree by parsimony SPR within --radius" << endl
     << "  --allnni             Perform more thorough NNI search (default: OFF)" << endl
     << "  -g FILE              (Multifurcating) topological constraint tree file" << endl
     << "  --fast               Fast search to resemble FastTree" << endl
@@ -5277,6 +5323,10 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --tree-fix           Fix -t tree (no tree search performed)" << endl
     << "  --treels             Write locally optimal trees into .treels file" << endl
     << "  --show-lh            Compute tree likelihood without optimisation" << endl
+    << "  --dist-packed        Keep distances for BIONJ in a packed triangular matrix" << endl
+    << "  --dist-float         Like --dist-packed but in single precision" << endl
+    << "  --dist-mmap FILE     Like --dist-packed but memory-mapped onto FILE" << endl
+    << "  --dist-stream        Compute distances while building BIONJ tree (no .mldist)" << endl
 #ifdef IQTREE_TERRAPHAST
     << "  --terrace            Check if the tree lies on a phylogenetic terrace" << endl
 #endif
@@ -5289,6 +5339,8 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --sampling STRING    GENE|GENESITE resampling for partitions (default: SITE)" << endl
     << "  --boot-trees         Write bootstrap trees to .ufboot file (default: none)" << endl
     << "  --wbtl               Like --boot-trees but also writing branch lengths" << endl
+    << "  --boot-trees-bin 32|64 Write bootstrap trees to binary .ufboot.bin file with" << endl
+    << "                       float/double branch lengths (with --wbtl)" << endl
 //            << "  -n <#iterations>     Minimum number of iterations (default: 100)" << endl
     << "  --nmax NUM           Maximum number of iterations (default: 1000)" << endl
     << "  --nstep NUM          Iterations for UFBoot stopping rule (default: 100)" << endl
@@ -5436,6 +5488,7 @@ void usage_iqtree(char* argv[], bool full_command) {
     << endl << "ANCESTRAL STATE RECONSTRUCTION:" << endl
     << "  --ancestral          Ancestral state reconstruction by empirical Bayes" << endl
     << "  --asr-min NUM        Min probability of ancestral state (default: equil freq)" << endl
+    << "  -gz                  Write ancestral states into a gzip-compressed .state.gz" << endl
 
     << endl << "TEST OF SYMMETRY:" << endl
     << "  --symtest               Perform three tests of symmetry" << endl
@@ -5473,6 +5526,7 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  -g_non_stop          Turn off all stopping rules." << endl
     << "  -g_query FILE        Species-trees to test for identical set of subtrees." << endl
     << "  -g_print             Write all generated species-trees. WARNING: there might be millions of trees!" << endl
+    << "                       Use -gz to write them gzip-compressed into .stand_trees.gz" << endl
     << "  -g_print_lim NUM     Limit on the number of species-trees to be written." << endl
     << "  -g_print_induced     Write induced partition subtrees." << endl
     << "  -g_print_m           Write presence-absence matrix." << endl
@@ -5535,6 +5589,7 @@ void usage_iqtree(char* argv[], bool full_command) {
         << "  -blscale             Scale branch lengths of user tree passed via -t" << endl
         << "  -blmin               Min branch length for optimization (default 0.000001)" << endl
         << "  -blmax               Max branch length for optimization (default 100)" << endl
+        << "  --bl-lbfgs           Optimize all branch lengths together by L-BFGS-B" << endl
         << "  -wslr                Write site log-likelihoods per rate category" << endl
         << "  -wslm                Write site log-likelihoods per mixture class" << endl
         << "  -wslmr               Write site log-likelihoods per mixture+rate class" << endl
@@ -6393,6 +6448,7 @@ json Params::to_json() const {
     j["maxCandidates"] = this->maxCandidates;  // int
     j["numInitTrees"] = this->numInitTrees;  // int
     j["sprDist"] = this->sprDist;  // int
+    j["pars_spr"] = this->pars_spr;  // bool
     j["sankoff_cost_file"] = std::string(this->sankoff_cost_file);  // char*
     j["numNNITrees"] = this->numNNITrees;  // int
     j["popSize"] = this->popSize;  // int
@@ -6511,6 +6567,10 @@ json Params::to_json() const {
     j["compute_obs_dist"] = this->compute_obs_dist;  // bool
     j["compute_jc_dist"] = this->compute_jc_dist;  // bool
     j["experimental"] = this->experimental;  // bool
+    j["packed_dist"] = this->packed_dist;  // bool
+    j["float_dist"] = this->float_dist;  // bool
+    j["dist_backing_file"] = this->dist_backing_file;  // std::string
+    j["stream_dist"] = this->stream_dist;  // bool
     j["compute_ml_dist"] = this->compute_ml_dist;  // bool
     j["compute_ml_tree"] = this->compute_ml_tree;  // bool
     j["compute_ml_tree_only"] = this->compute_ml_tree_only;  // bool
@@ -6604,6 +6664,7 @@ json Params::to_json() const {
     j["p_invar_sites"] = this->p_invar_sites;  // bool
     j["optimize_model_rate_joint"] = this->optimize_model_rate_joint;  // bool
     j["optimize_by_newton"] = this->optimize_by_newton;  // bool
+    j["optimize_brlen_lbfgs"] = this->optimize_brlen_lbfgs;  // bool
     j["optimize_alg_freerate"] = this->optimize_alg_freerate;  // string
     j["optimize_alg_mixlen"] = this->optimize_alg_mixlen;  // string
     j["optimize_alg_gammai"] = this->optimize_alg_gammai;  // string
@@ -6697,6 +6758,7 @@ json Params::to_json() const {
     j["min_correlation"] = this->min_correlation;  // double
     j["step_iterations"] = this->step_iterations;  // int
     j["print_ufboot_trees"] = this->print_ufboot_trees;  // double
+    j["print_ufboot_bin"] = this->print_ufboot_bin;  // int
     j["jackknife_prop"] = this->jackknife_prop;  // double
     j["robust_phy_keep"] = this->robust_phy_keep;  // double
     j["robust_median"] = this->robust_median;  // bool
@@ -6846,6 +6908,7 @@ void Params::from_json(const json& j) {
     if (j.contains("maxCandidates")) this->maxCandidates = j["maxCandidates"].get<int>(); // int
     if (j.contains("numInitTrees")) this->numInitTrees = j["numInitTrees"].get<int>(); // int
     if (j.contains("sprDist")) this->sprDist = j["sprDist"].get<int>(); // int
+    if (j.contains("pars_spr")) this->pars_spr = j["pars_spr"].get<bool>(); // bool
     if (j.contains("sankoff_cost_file")) {
         std::string str = j["sankoff_cost_file"].get<std::string>();
         if (this->sankoff_cost_file != nullptr) {
@@ -7114,6 +7177,12 @@ void Params::from_json(const json& j) {
     if (j.contains("compute_obs_dist")) this->compute_obs_dist = j["compute_obs_dist"].get<bool>(); // bool
     if (j.contains("compute_jc_dist")) this->compute_jc_dist = j["compute_jc_dist"].get<bool>(); // bool
     if (j.contains("experimental")) this->experimental = j["experimental"].get<bool>(); // bool
+    if (j.contains("packed_dist")) this->packed_dist = j["packed_dist"].get<bool>(); // bool
+    if (j.contains("float_dist")) this->float_dist = j["float_dist"].get<bool>(); // bool
+    if (j.contains("dist_backing_file")) {
+        this->dist_backing_file = j["dist_backing_file"].get<std::string>();
+    } // std::string
+    if (j.contains("stream_dist")) this->stream_dist = j["stream_dist"].get<bool>(); // bool
     if (j.contains("compute_ml_dist")) this->compute_ml_dist = j["compute_ml_dist"].get<bool>(); // bool
     if (j.contains("compute_ml_tree")) this->compute_ml_tree = j["compute_ml_tree"].get<bool>(); // bool
     if (j.contains("compute_ml_tree_only")) this->compute_ml_tree_only = j["compute_ml_tree_only"].get<bool>(); // bool
@@ -7301,6 +7370,7 @@ void Params::from_json(const json& j) {
     if (j.contains("p_invar_sites")) this->p_invar_sites = j["p_invar_sites"].get<bool>(); // bool
     if (j.contains("optimize_model_rate_joint")) this->optimize_model_rate_joint = j["optimize_model_rate_joint"].get<bool>(); // bool
     if (j.contains("optimize_by_newton")) this->optimize_by_newton = j["optimize_by_newton"].get<bool>(); // bool
+    if (j.contains("optimize_brlen_lbfgs")) this->optimize_brlen_lbfgs = j["optimize_brlen_lbfgs"].get<bool>(); // bool
     if (j.contains("optimize_alg_freerate")) this->optimize_alg_freerate = j["optimize_alg_freerate"].get<std::string>(); // string
     if (j.contains("optimize_alg_mixlen")) this->optimize_alg_mixlen = j["optimize_alg_mixlen"].get<std::string>(); // string
     if (j.contains("optimize_alg_gammai")) this->optimize_alg_gammai = j["optimize_alg_gammai"].get<std::string>(); // string
@@ -7453,6 +7523,7 @@ void Params::from_json(const json& j) {
     if (j.contains("min_correlation")) this->min_correlation = j["min_correlation"].get<double>();
     if (j.contains("step_iterations")) this->step_iterations = j["step_iterations"].get<int>();
     if (j.contains("print_ufboot_trees")) this->print_ufboot_trees = j["print_ufboot_trees"].get<double>();
+    if (j.contains("print_ufboot_bin")) this->print_ufboot_bin = j["print_ufboot_bin"].get<int>();
     if (j.contains("jackknife_prop")) this->jackknife_prop = j["jackknife_prop"].get<double>();
     if (j.contains("robust_phy_keep")) this->robust_phy_keep = j["robust_phy_keep"].get<double>();
     if (j.contains("robust_median")) this->robust_median = j["robust_median"].get<bool>();
@@ -7672,6 +7743,7 @@ json Params::get_param(const std::string& name) const {
     else if (name == "maxCandidates") j[name] = this->maxCandidates;
     else if (name == "numInitTrees") j[name] = this->numInitTrees;
     else if (name == "sprDist") j[name] = this->sprDist;
+    else if (name == "pars_spr") j[name] = this->pars_spr;
     else if (name == "sankoff_cost_file") j[name] = std::string(this->sankoff_cost_file);
     else if (name == "numNNITrees") j[name] = this->numNNITrees;
     else if (name == "popSize") j[name] = this->popSize;
@@ -7790,6 +7862,10 @@ json Params::get_param(const std::string& name) const {
     else if (name == "compute_obs_dist") j[name] = this->compute_obs_dist;
     else if (name == "compute_jc_dist") j[name] = this->compute_jc_dist;
     else if (name == "experimental") j[name] = this->experimental;
+    else if (name == "packed_dist") j[name] = this->packed_dist;
+    else if (name == "float_dist") j[name] = this->float_dist;
+    else if (name == "dist_backing_file") j[name] = this->dist_backing_file;
+    else if (name == "stream_dist") j[name] = this->stream_dist;
     else if (name == "compute_ml_dist") j[name] = this->compute_ml_dist;
     else if (name == "compute_ml_tree") j[name] = this->compute_ml_tree;
     else if (name == "compute_ml_tree_only") j[name] = this->compute_ml_tree_only;
@@ -7884,6 +7960,7 @@ json Params::get_param(const std::string& name) const {
     else if (name == "p_invar_sites") j[name] = this->p_invar_sites;
     else if (name == "optimize_model_rate_joint") j[name] = this->optimize_model_rate_joint; 
     else if (name == "optimize_by_newton") j[name] = this->optimize_by_newton; 
+    else if (name == "optimize_brlen_lbfgs") j[name] = this->optimize_brlen_lbfgs; 
     else if (name == "optimize_alg_freerate") j[name] = std::string(this->optimize_alg_freerate);
     else if (name == "optimize_alg_mixlen") j[name] = std::string(this->optimize_alg_mixlen);
     else if (name == "optimize_alg_gammai") j[name] = std::string(this->optimize_alg_gammai);
@@ -7978,6 +8055,7 @@ json Params::get_param(const std::string& name) const {
     else if (name == "min_correlation") j[name] = this->min_correlation;
     else if (name == "step_iterations") j[name] = this->step_iterations;
     else if (name == "print_ufboot_trees") j[name] = this->print_ufboot_trees;
+    else if (name == "print_ufboot_bin") j[name] = this->print_ufboot_bin;
     else if (name == "jackknife_prop") j[name] = this->jackknife_prop;
 
     else if (name == "robust_phy_keep") j[name] = this->robust_phy_keep;
@@ -8138,6 +8216,10 @@ void Params::setDefault(){
     this->compute_obs_dist = false;
     this->compute_jc_dist = true;
     this->experimental = true;
+    this->packed_dist = false;
+    this->float_dist = false;
+    this->dist_backing_file = "";
+    this->stream_dist = false;
     this->compute_ml_dist = true;
     this->compute_ml_tree = true;
     this->compute_ml_tree_only = false;
@@ -8290,6 +8372,7 @@ void Params::setDefault(){
     this->p_invar_sites = -1.0;
     this->optimize_model_rate_joint = false;
     this->optimize_by_newton = true;
+    this->optimize_brlen_lbfgs = false;
     this->optimize_alg_freerate = "2-BFGS,EM";
     this->optimize_alg_mixlen = "EM";
     this->optimize_alg_gammai = "EM";
@@ -8380,6 +8463,7 @@ void Params::setDefault(){
     this->step_iterations = 100;
 //    this->store_candidate_trees = false;
 	this->print_ufboot_trees = 0;
+	this->print_ufboot_bin = 0;
     this->jackknife_prop = 0.0;
     this->robust_phy_keep = 1.0;
     this->robust_median = false;
@@ -8421,6 +8505,7 @@ void Params::setDefault(){
     this->numSupportTrees = 20;
 //    this->sprDist = 20;
     this->sprDist = 6;
+    this->pars_spr = false;
     this->sankoff_cost_file = NULL;
     this->numNNITrees = 20;
     this->avh_test = 0;
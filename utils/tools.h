@@ -916,7 +916,7 @@ inline void from_json(const json& j, LEAST_SQUARE_VAR& value) {
     else throw std::runtime_error("LEAST_SQUARE_VAR: unknown value " + str);
  }
 enum START_TREE_TYPE {
-	STT_BIONJ, STT_PARSIMONY, STT_PLL_PARSIMONY, STT_RANDOM_TREE, STT_USER_TREE
+	STT_BIONJ, STT_PARSIMONY, STT_PLL_PARSIMONY, STT_RANDOM_TREE, STT_USER_TREE, STT_SKETCH
 };
 /**
  * Serialize START_TREE_TYPE to json 
@@ -929,6 +929,7 @@ inline void to_json(json& j, const START_TREE_TYPE& value) {
         case STT_PLL_PARSIMONY: j = "STT_PLL_PARSIMONY"; break;
         case STT_RANDOM_TREE: j = "STT_RANDOM_TREE"; break;
         case STT_USER_TREE: j = "STT_USER_TREE"; break;
+        case STT_SKETCH: j = "STT_SKETCH"; break;
     }
 }
 /**
@@ -942,6 +943,7 @@ inline void from_json(const json& j, START_TREE_TYPE& value) {
     else if (str == "STT_PLL_PARSIMONY") value = STT_PLL_PARSIMONY;
     else if (str == "STT_RANDOM_TREE") value = STT_RANDOM_TREE;
     else if (str == "STT_USER_TREE") value = STT_USER_TREE;
+    else if (str == "STT_SKETCH") value = STT_SKETCH;
     else throw std::runtime_error("START_TREE_TYPE: unknown value " + str);
 }
 
@@ -1338,6 +1340,11 @@ public:
 	 */
 	int sprDist;
 
+	/**
+	 *  TRUE to improve the native parsimony tree (-t PARS) by SPR moves within sprDist, default: FALSE
+	 */
+	bool pars_spr;
+
     /** cost matrix file for Sankoff parsimony */
     char *sankoff_cost_file;
     
@@ -1874,6 +1881,28 @@ public:
      */
     bool experimental;
 
+    /**
+            TRUE to compute distances into packed (upper-triangular) storage, in tiles,
+            writing them straight to the distance file, default: FALSE
+     */
+    bool packed_dist;
+
+    /**
+            TRUE to store packed distances in single precision (implies packed_dist), default: FALSE
+     */
+    bool float_dist;
+
+    /**
+            file from which packed distances are memory-mapped (empty for in-memory)
+     */
+    std::string dist_backing_file;
+
+    /**
+            TRUE to calculate distances only as the start tree builder loads them
+            (no square distance matrix, and no distance file), default: FALSE
+     */
+    bool stream_dist;
+
     /**
             TRUE to compute the maximum-likelihood distances
      */
@@ -2296,6 +2325,12 @@ public:
      */
     bool optimize_by_newton;
 
+    /**
+            TRUE to optimize all branch lengths together by L-BFGS-B on the full gradient
+            instead of Newton-Raphson on one branch at a time
+     */
+    bool optimize_brlen_lbfgs;
+
     /** optimization algorithm for free rate model: 1-BFGS, 2-BFGS, EM */
     string optimize_alg_freerate;
 
@@ -2739,6 +2774,9 @@ public:
 	/** true to print all UFBoot trees to a file */
 	int print_ufboot_trees;
 
+	/** 32 or 64 to print UFBoot trees to a binary tree file with float or double branch lengths, 0 for NEWICK */
+	int print_ufboot_bin;
+
     /**********************************************/
     /**** variables for jackknife ******************/
 